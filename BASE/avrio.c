@@ -57,6 +57,15 @@ void digitalWrite(uint8_t pin, uint8_t val)
 	}
 }
 
+TPinHandle pin_resolve(uint8_t pin)
+{
+	TPinHandle handle;
+
+	handle.reg = (volatile uint8_t *) portInputRegister(digitalPinToPort(pin));
+	handle.mask = digitalPinToBitMask(pin);
+	return handle;
+}
+
 int digitalRead(uint8_t pin)
 {
     uint8_t bit = digitalPinToBitMask(pin);
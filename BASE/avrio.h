@@ -69,6 +69,58 @@
 
    -------------------------------------------------------------------------
 
+   ATOMIC_DIGITAL_WRITE(pin0, ..., pin7, value)
+   ATOMIC_PINMODE(pin0, ..., pin7, type)
+     The same as DIGITAL_WRITE and PINMODE, but safe when an interrupt routine
+     changes other pins of the same port. Single pin at low I/O address 
+     uses sbi/cbi (atomic instruction), other cases (several pins, PORTH..PORTL
+     on ATmega2560) use the read-modify-write with disabled interrupts. 
+     When AVRIO_PIN_TOGGLE is 1, PORT bits are changed by writing ones 
+     to the PIN register (toggle) without disabling interrupts. It is 
+     enabled by default on devices with PCICR register (the newer devices
+     which support the toggle).
+
+   -------------------------------------------------------------------------
+
+   BUS_WRITE(value, pin0, ..., pin7)
+   BUS_READ(pin0, ..., pin7)
+     Write/read parallel bus - bit 0 of value belongs to pin0, bit 1 to
+     pin1, etc. Pins are grouped by ports at compile time, so every port
+     register is read (and written) only once. The bits are moved by
+     constant shifts, the pins which lie contiguously in the same order
+     need only one shift. All pins must be constant values.
+
+     For example:
+        BUS_WRITE(value, ioPB2, ioPB3, ioPB4, ioPD7) is converted to:
+        PORTB = (PORTB & ~0x1C) | ((value << 2) & 0x1C);
+        PORTD = (PORTD & ~0x80) | ((value << 4) & 0x80);
+
+   ATOMIC_BUS_WRITE(value, pin0, ..., pin7)
+     The same as BUS_WRITE, but the read-modify-write of the port registers
+     runs with disabled interrupts. Use it when an interrupt routine changes
+     other pins of the same ports.
+
+   -------------------------------------------------------------------------
+
+   TPinHandle h = pin_resolve(pin)
+   pin_mode(&h, type)
+   pin_write(&h, value)
+   pin_read(&h)
+   pin_toggle(&h)
+     Pin handle for pins which are known only in runtime (e.g. stored in
+     a structure) and are used repeatedly. Function pin_resolve finds
+     the register address and the bit mask once, the inline functions
+     pin_mode/write/read/toggle then access the registers directly
+     without the table lookup of pinMode, digitalWrite and digitalRead.
+
+   atomic_pin_mode(&h, type)
+   atomic_pin_write(&h, value)
+   atomic_pin_toggle(&h)
+     The same as pin_mode/write/toggle, but safe when an interrupt routine
+     changes other pins of the same port (like ATOMIC_DIGITAL_WRITE).
+
+   -------------------------------------------------------------------------
+
 */
 
 #ifndef AVRIO_H_INCLUDED
@@ -77,6 +129,7 @@
 
 #include <avr/pgmspace.h>
 #include <avr/../inttypes.h>
+#include <util/atomic.h>
 
 #include "preprocessor.h"
 #include "avrio_pins.h"
@@ -288,15 +341,15 @@ Pin number is format PPPPPBBB, where
            digitalPinToBitMask(pin6) | \
            digitalPinToBitMask(pin7);
 
-#define CLEAR_IOSET_BITS8(reg, pin0, pin1, pin2, pin3, pin4, pin5, pin6)   \
-    reg &= ~digitalPinToBitMask(pin0) & \
-           ~digitalPinToBitMask(pin1) & \
-           ~digitalPinToBitMask(pin2) & \
-           ~digitalPinToBitMask(pin3) & \
-           ~digitalPinToBitMask(pin4) & \
-           ~digitalPinToBitMask(pin5) & \
-           ~digitalPinToBitMask(pin6) & \
-           ~digitalPinToBitMask(pin7);
+#define CLEAR_IOSET_BITS8(reg, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)   \
+    reg &= (uint8_t) (~digitalPinToBitMask(pin0) & \
+                      ~digitalPinToBitMask(pin1) & \
+                      ~digitalPinToBitMask(pin2) & \
+                      ~digitalPinToBitMask(pin3) & \
+                      ~digitalPinToBitMask(pin4) & \
+                      ~digitalPinToBitMask(pin5) & \
+                      ~digitalPinToBitMask(pin6) & \
+                      ~digitalPinToBitMask(pin7));
 
 /*
   Set/clear bits inside the register reg
@@ -470,9 +523,433 @@ Pin number is format PPPPPBBB, where
                ERROR)(__VA_ARGS__)
 
 
+/* Interrupt safe variants of the register bit manipulation, see ioSET_BITS.
+   ATOMIC_SET, ATOMIC_CLEAR    - any register (DDR, PORT)
+   ATOMIC_PORT_SET, ATOMIC_PORT_CLEAR - PORT register, PIN toggle is used
+                                 when the device supports it
+ */
+#ifndef AVRIO_PIN_TOGGLE
+  #ifdef PCICR
+    #define AVRIO_PIN_TOGGLE 1
+  #else
+    #define AVRIO_PIN_TOGGLE 0
+  #endif
+#endif
+
+#define _IOSET_MASK1(pin0) digitalPinToBitMask(pin0)
+#define _IOSET_MASK2(pin0, ...) (digitalPinToBitMask(pin0) | _IOSET_MASK1(__VA_ARGS__))
+#define _IOSET_MASK3(pin0, ...) (digitalPinToBitMask(pin0) | _IOSET_MASK2(__VA_ARGS__))
+#define _IOSET_MASK4(pin0, ...) (digitalPinToBitMask(pin0) | _IOSET_MASK3(__VA_ARGS__))
+#define _IOSET_MASK5(pin0, ...) (digitalPinToBitMask(pin0) | _IOSET_MASK4(__VA_ARGS__))
+#define _IOSET_MASK6(pin0, ...) (digitalPinToBitMask(pin0) | _IOSET_MASK5(__VA_ARGS__))
+#define _IOSET_MASK7(pin0, ...) (digitalPinToBitMask(pin0) | _IOSET_MASK6(__VA_ARGS__))
+#define _IOSET_MASK8(pin0, ...) (digitalPinToBitMask(pin0) | _IOSET_MASK7(__VA_ARGS__))
+
+#define _IOSET_MASK(...)                    \
+    GET_MACRO8(__VA_ARGS__,                 \
+               _IOSET_MASK8,                \
+               _IOSET_MASK7,                \
+               _IOSET_MASK6,                \
+               _IOSET_MASK5,                \
+               _IOSET_MASK4,                \
+               _IOSET_MASK3,                \
+               _IOSET_MASK2,                \
+               _IOSET_MASK1)(__VA_ARGS__)
+
+#define _ATOMIC_SET(reg, ...)                               \
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {                     \
+        reg |= _IOSET_MASK(__VA_ARGS__);                    \
+    }
+
+#define _ATOMIC_CLEAR(reg, ...)                             \
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {                     \
+        reg &= ~_IOSET_MASK(__VA_ARGS__);                   \
+    }
+
+/* Writing one to PIN bit toggles PORT bit, other bits are not changed */
+#if AVRIO_PIN_TOGGLE
+  #define _ATOMIC_PORT_SET(reg, pin0, ...)                  \
+      ioPIN(pin0) = ~reg & _IOSET_MASK(pin0, ## __VA_ARGS__);
+
+  #define _ATOMIC_PORT_CLEAR(reg, pin0, ...)                \
+      ioPIN(pin0) = reg & _IOSET_MASK(pin0, ## __VA_ARGS__);
+#else
+  #define _ATOMIC_PORT_SET(reg, ...) _ATOMIC_SET(reg, __VA_ARGS__)
+  #define _ATOMIC_PORT_CLEAR(reg, ...) _ATOMIC_CLEAR(reg, __VA_ARGS__)
+#endif
+
+/* Single pin - sbi/cbi when the register is in the low I/O space */
+#define _ATOMIC_IOSET_BITS1(mode, atomic, reg, pin0)        \
+    if (_SFR_IO_ADDR(reg) <= 0x1F) {                        \
+        mode##_IOSET_BITS1(reg, pin0)                       \
+    } else {                                                \
+        atomic(reg, pin0)                                   \
+    }
+
+#define ATOMIC_SET_IOSET_BITS0(reg)
+#define ATOMIC_SET_IOSET_BITS1(reg, pin0) _ATOMIC_IOSET_BITS1(SET, _ATOMIC_SET, reg, pin0)
+#define ATOMIC_SET_IOSET_BITS2(reg, ...) _ATOMIC_SET(reg, __VA_ARGS__)
+#define ATOMIC_SET_IOSET_BITS3(reg, ...) _ATOMIC_SET(reg, __VA_ARGS__)
+#define ATOMIC_SET_IOSET_BITS4(reg, ...) _ATOMIC_SET(reg, __VA_ARGS__)
+#define ATOMIC_SET_IOSET_BITS5(reg, ...) _ATOMIC_SET(reg, __VA_ARGS__)
+#define ATOMIC_SET_IOSET_BITS6(reg, ...) _ATOMIC_SET(reg, __VA_ARGS__)
+#define ATOMIC_SET_IOSET_BITS7(reg, ...) _ATOMIC_SET(reg, __VA_ARGS__)
+#define ATOMIC_SET_IOSET_BITS8(reg, ...) _ATOMIC_SET(reg, __VA_ARGS__)
+
+#define ATOMIC_CLEAR_IOSET_BITS0(reg)
+#define ATOMIC_CLEAR_IOSET_BITS1(reg, pin0) _ATOMIC_IOSET_BITS1(CLEAR, _ATOMIC_CLEAR, reg, pin0)
+#define ATOMIC_CLEAR_IOSET_BITS2(reg, ...) _ATOMIC_CLEAR(reg, __VA_ARGS__)
+#define ATOMIC_CLEAR_IOSET_BITS3(reg, ...) _ATOMIC_CLEAR(reg, __VA_ARGS__)
+#define ATOMIC_CLEAR_IOSET_BITS4(reg, ...) _ATOMIC_CLEAR(reg, __VA_ARGS__)
+#define ATOMIC_CLEAR_IOSET_BITS5(reg, ...) _ATOMIC_CLEAR(reg, __VA_ARGS__)
+#define ATOMIC_CLEAR_IOSET_BITS6(reg, ...) _ATOMIC_CLEAR(reg, __VA_ARGS__)
+#define ATOMIC_CLEAR_IOSET_BITS7(reg, ...) _ATOMIC_CLEAR(reg, __VA_ARGS__)
+#define ATOMIC_CLEAR_IOSET_BITS8(reg, ...) _ATOMIC_CLEAR(reg, __VA_ARGS__)
+
+#define ATOMIC_PORT_SET_IOSET_BITS0(reg)
+#define ATOMIC_PORT_SET_IOSET_BITS1(reg, pin0) _ATOMIC_IOSET_BITS1(SET, _ATOMIC_PORT_SET, reg, pin0)
+#define ATOMIC_PORT_SET_IOSET_BITS2(reg, ...) _ATOMIC_PORT_SET(reg, __VA_ARGS__)
+#define ATOMIC_PORT_SET_IOSET_BITS3(reg, ...) _ATOMIC_PORT_SET(reg, __VA_ARGS__)
+#define ATOMIC_PORT_SET_IOSET_BITS4(reg, ...) _ATOMIC_PORT_SET(reg, __VA_ARGS__)
+#define ATOMIC_PORT_SET_IOSET_BITS5(reg, ...) _ATOMIC_PORT_SET(reg, __VA_ARGS__)
+#define ATOMIC_PORT_SET_IOSET_BITS6(reg, ...) _ATOMIC_PORT_SET(reg, __VA_ARGS__)
+#define ATOMIC_PORT_SET_IOSET_BITS7(reg, ...) _ATOMIC_PORT_SET(reg, __VA_ARGS__)
+#define ATOMIC_PORT_SET_IOSET_BITS8(reg, ...) _ATOMIC_PORT_SET(reg, __VA_ARGS__)
+
+#define ATOMIC_PORT_CLEAR_IOSET_BITS0(reg)
+#define ATOMIC_PORT_CLEAR_IOSET_BITS1(reg, pin0) _ATOMIC_IOSET_BITS1(CLEAR, _ATOMIC_PORT_CLEAR, reg, pin0)
+#define ATOMIC_PORT_CLEAR_IOSET_BITS2(reg, ...) _ATOMIC_PORT_CLEAR(reg, __VA_ARGS__)
+#define ATOMIC_PORT_CLEAR_IOSET_BITS3(reg, ...) _ATOMIC_PORT_CLEAR(reg, __VA_ARGS__)
+#define ATOMIC_PORT_CLEAR_IOSET_BITS4(reg, ...) _ATOMIC_PORT_CLEAR(reg, __VA_ARGS__)
+#define ATOMIC_PORT_CLEAR_IOSET_BITS5(reg, ...) _ATOMIC_PORT_CLEAR(reg, __VA_ARGS__)
+#define ATOMIC_PORT_CLEAR_IOSET_BITS6(reg, ...) _ATOMIC_PORT_CLEAR(reg, __VA_ARGS__)
+#define ATOMIC_PORT_CLEAR_IOSET_BITS7(reg, ...) _ATOMIC_PORT_CLEAR(reg, __VA_ARGS__)
+#define ATOMIC_PORT_CLEAR_IOSET_BITS8(reg, ...) _ATOMIC_PORT_CLEAR(reg, __VA_ARGS__)
+
+/* Input parameters:
+     value - condition (DIGITAL_WRITE) or pin mode (PINMODE)
+ */
+#define _ATOMIC_DIGITAL_WRITE(value, ...)                       \
+    do {                                                        \
+        if (value) {                                            \
+            _SET_PINS4REG(PORT, ATOMIC_PORT_SET, __VA_ARGS__)   \
+        } else {                                                \
+            _SET_PINS4REG(PORT, ATOMIC_PORT_CLEAR, __VA_ARGS__) \
+        }                                                       \
+    } while (0)
+
+#define _ATOMIC_PINMODE(mode, ...)                              \
+    do {                                                        \
+        if ((mode) == INPUT) {                                  \
+            _SET_PINS4REG(DDR, ATOMIC_CLEAR, __VA_ARGS__)       \
+            _SET_PINS4REG(PORT, ATOMIC_PORT_CLEAR, __VA_ARGS__) \
+        } else if ((mode) == INPUT_PULLUP) {                    \
+            _SET_PINS4REG(DDR, ATOMIC_CLEAR, __VA_ARGS__)       \
+            _SET_PINS4REG(PORT, ATOMIC_PORT_SET, __VA_ARGS__)   \
+        } else {                                                \
+            _SET_PINS4REG(DDR, ATOMIC_SET, __VA_ARGS__)         \
+        }                                                       \
+    } while (0)
+
+#define _ATOMIC_DIGITAL_WRITE1(pin0, value) _ATOMIC_DIGITAL_WRITE(value, pin0)
+#define _ATOMIC_DIGITAL_WRITE2(pin0, pin1, value) _ATOMIC_DIGITAL_WRITE(value, pin0, pin1)
+#define _ATOMIC_DIGITAL_WRITE3(pin0, pin1, pin2, value) _ATOMIC_DIGITAL_WRITE(value, pin0, pin1, pin2)
+#define _ATOMIC_DIGITAL_WRITE4(pin0, pin1, pin2, pin3, value) _ATOMIC_DIGITAL_WRITE(value, pin0, pin1, pin2, pin3)
+#define _ATOMIC_DIGITAL_WRITE5(pin0, pin1, pin2, pin3, pin4, value) _ATOMIC_DIGITAL_WRITE(value, pin0, pin1, pin2, pin3, pin4)
+#define _ATOMIC_DIGITAL_WRITE6(pin0, pin1, pin2, pin3, pin4, pin5, value) _ATOMIC_DIGITAL_WRITE(value, pin0, pin1, pin2, pin3, pin4, pin5)
+#define _ATOMIC_DIGITAL_WRITE7(pin0, pin1, pin2, pin3, pin4, pin5, pin6, value) _ATOMIC_DIGITAL_WRITE(value, pin0, pin1, pin2, pin3, pin4, pin5, pin6)
+#define _ATOMIC_DIGITAL_WRITE8(pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7, value) _ATOMIC_DIGITAL_WRITE(value, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)
+
+#define ATOMIC_DIGITAL_WRITE(...)          \
+    GET_MACRO9(__VA_ARGS__,                \
+               _ATOMIC_DIGITAL_WRITE8,     \
+               _ATOMIC_DIGITAL_WRITE7,     \
+               _ATOMIC_DIGITAL_WRITE6,     \
+               _ATOMIC_DIGITAL_WRITE5,     \
+               _ATOMIC_DIGITAL_WRITE4,     \
+               _ATOMIC_DIGITAL_WRITE3,     \
+               _ATOMIC_DIGITAL_WRITE2,     \
+               _ATOMIC_DIGITAL_WRITE1,     \
+               ERROR)(__VA_ARGS__)
+
+#define _ATOMIC_PINMODE1(pin0, mode) _ATOMIC_PINMODE(mode, pin0)
+#define _ATOMIC_PINMODE2(pin0, pin1, mode) _ATOMIC_PINMODE(mode, pin0, pin1)
+#define _ATOMIC_PINMODE3(pin0, pin1, pin2, mode) _ATOMIC_PINMODE(mode, pin0, pin1, pin2)
+#define _ATOMIC_PINMODE4(pin0, pin1, pin2, pin3, mode) _ATOMIC_PINMODE(mode, pin0, pin1, pin2, pin3)
+#define _ATOMIC_PINMODE5(pin0, pin1, pin2, pin3, pin4, mode) _ATOMIC_PINMODE(mode, pin0, pin1, pin2, pin3, pin4)
+#define _ATOMIC_PINMODE6(pin0, pin1, pin2, pin3, pin4, pin5, mode) _ATOMIC_PINMODE(mode, pin0, pin1, pin2, pin3, pin4, pin5)
+#define _ATOMIC_PINMODE7(pin0, pin1, pin2, pin3, pin4, pin5, pin6, mode) _ATOMIC_PINMODE(mode, pin0, pin1, pin2, pin3, pin4, pin5, pin6)
+#define _ATOMIC_PINMODE8(pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7, mode) _ATOMIC_PINMODE(mode, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)
+
+#define ATOMIC_PINMODE(...)                \
+    GET_MACRO9(__VA_ARGS__,                \
+               _ATOMIC_PINMODE8,           \
+               _ATOMIC_PINMODE7,           \
+               _ATOMIC_PINMODE6,           \
+               _ATOMIC_PINMODE5,           \
+               _ATOMIC_PINMODE4,           \
+               _ATOMIC_PINMODE3,           \
+               _ATOMIC_PINMODE2,           \
+               _ATOMIC_PINMODE1,           \
+               ERROR)(__VA_ARGS__)
+
+
+/* Parallel bus. Missing pins are NOT_A_PIN, which does not belong to
+   any port. Bit i of value is moved to the pin bit by the shift
+   (pin bit - i). Pins are grouped by the shift, so one shift and one
+   mask are used for every group (e.g. contiguous pins) and the groups
+   without any pin are constant 0.
+ */
+#define _BUS_ON_PORT(port, pin) (digitalPinToPort(pin) == (port))
+
+#define _BUS_MASK(port, pin) \
+    (_BUS_ON_PORT(port, pin) ? digitalPinToBitMask(pin) : 0)
+
+#define _BUS_MASK8(port, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)   \
+    (uint8_t) (_BUS_MASK(port, pin0) | _BUS_MASK(port, pin1) |              \
+               _BUS_MASK(port, pin2) | _BUS_MASK(port, pin3) |              \
+               _BUS_MASK(port, pin4) | _BUS_MASK(port, pin5) |              \
+               _BUS_MASK(port, pin6) | _BUS_MASK(port, pin7))
+
+/* Mask of the pin if bit i of the bus is moved by shift to this pin */
+#define _BUS_SHIFT_PIN(port, shift, i, pin)                                \
+    ((_BUS_ON_PORT(port, pin) && (digitalPinToBit(pin) == (i) + (shift))) ? \
+        digitalPinToBitMask(pin) : 0)
+
+/* Register mask of all pins with given shift */
+#define _BUS_SHIFT_MASK(port, shift, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7) \
+    (_BUS_SHIFT_PIN(port, shift, 0, pin0) | _BUS_SHIFT_PIN(port, shift, 1, pin1) |    \
+     _BUS_SHIFT_PIN(port, shift, 2, pin2) | _BUS_SHIFT_PIN(port, shift, 3, pin3) |    \
+     _BUS_SHIFT_PIN(port, shift, 4, pin4) | _BUS_SHIFT_PIN(port, shift, 5, pin5) |    \
+     _BUS_SHIFT_PIN(port, shift, 6, pin6) | _BUS_SHIFT_PIN(port, shift, 7, pin7))
+
+/* Bus value moved to the register bits */
+#define _BUS_TO_PORT(port, value, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7) \
+    (uint8_t) ((((value) << 7) & _BUS_SHIFT_MASK(port, 7, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) |  \
+               (((value) << 6) & _BUS_SHIFT_MASK(port, 6, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) |  \
+               (((value) << 5) & _BUS_SHIFT_MASK(port, 5, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) |  \
+               (((value) << 4) & _BUS_SHIFT_MASK(port, 4, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) |  \
+               (((value) << 3) & _BUS_SHIFT_MASK(port, 3, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) |  \
+               (((value) << 2) & _BUS_SHIFT_MASK(port, 2, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) |  \
+               (((value) << 1) & _BUS_SHIFT_MASK(port, 1, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) |  \
+               ((value) & _BUS_SHIFT_MASK(port, 0, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) |  \
+               (((value) >> 1) & _BUS_SHIFT_MASK(port, -1, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) |  \
+               (((value) >> 2) & _BUS_SHIFT_MASK(port, -2, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) |  \
+               (((value) >> 3) & _BUS_SHIFT_MASK(port, -3, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) |  \
+               (((value) >> 4) & _BUS_SHIFT_MASK(port, -4, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) |  \
+               (((value) >> 5) & _BUS_SHIFT_MASK(port, -5, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) |  \
+               (((value) >> 6) & _BUS_SHIFT_MASK(port, -6, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) |  \
+               (((value) >> 7) & _BUS_SHIFT_MASK(port, -7, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)))
+
+/* Register bits moved to the bus value */
+#define _BUS_FROM_PORT(port, reg_value, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7) \
+    (uint8_t) ((((reg_value) & _BUS_SHIFT_MASK(port, 7, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) >> 7) |  \
+               (((reg_value) & _BUS_SHIFT_MASK(port, 6, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) >> 6) |  \
+               (((reg_value) & _BUS_SHIFT_MASK(port, 5, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) >> 5) |  \
+               (((reg_value) & _BUS_SHIFT_MASK(port, 4, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) >> 4) |  \
+               (((reg_value) & _BUS_SHIFT_MASK(port, 3, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) >> 3) |  \
+               (((reg_value) & _BUS_SHIFT_MASK(port, 2, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) >> 2) |  \
+               (((reg_value) & _BUS_SHIFT_MASK(port, 1, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) >> 1) |  \
+               ((reg_value) & _BUS_SHIFT_MASK(port, 0, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) |  \
+               (((reg_value) & _BUS_SHIFT_MASK(port, -1, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) << 1) |  \
+               (((reg_value) & _BUS_SHIFT_MASK(port, -2, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) << 2) |  \
+               (((reg_value) & _BUS_SHIFT_MASK(port, -3, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) << 3) |  \
+               (((reg_value) & _BUS_SHIFT_MASK(port, -4, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) << 4) |  \
+               (((reg_value) & _BUS_SHIFT_MASK(port, -5, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) << 5) |  \
+               (((reg_value) & _BUS_SHIFT_MASK(port, -6, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) << 6) |  \
+               (((reg_value) & _BUS_SHIFT_MASK(port, -7, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) << 7))
+
+#define _BUS_WRITE_REG(reg, port, value, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7) \
+    if (_BUS_MASK8(port, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7) == 0xFF) {    \
+        reg = _BUS_TO_PORT(port, value, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7); \
+    } else if (_BUS_MASK8(port, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) {     \
+        reg = (reg & ~_BUS_MASK8(port, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) | \
+              _BUS_TO_PORT(port, value, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7); \
+    }
+
+#define _BUS_READ_REG(reg, port, result, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7) \
+    if (_BUS_MASK8(port, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7)) {            \
+        uint8_t _bus_reg = reg;                                                       \
+        result |= _BUS_FROM_PORT(port, _bus_reg, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7); \
+    }
+
+/* Input parameters:
+     mode      - WRITE, READ
+     port_name - A, B, C, ...
+     arg       - value (WRITE) or result variable (READ)
+ */
+#define _BUS_PORT_ITEM(mode, port_name, arg, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7) \
+    IIF_PORT##port_name(                                                                   \
+        _BUS_##mode##_REG(_BUS_REG_##mode(port_name), ioPORT##port_name, arg,              \
+                          pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7),                 \
+        EMPTY()                                                                            \
+    )
+
+#define _BUS_REG_WRITE(port_name) PORT##port_name
+#define _BUS_REG_READ(port_name) PIN##port_name
+
+#define _BUS8(mode, arg, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7) \
+        _BUS_PORT_ITEM(mode, A, arg, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7) \
+        _BUS_PORT_ITEM(mode, B, arg, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7) \
+        _BUS_PORT_ITEM(mode, C, arg, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7) \
+        _BUS_PORT_ITEM(mode, D, arg, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7) \
+        _BUS_PORT_ITEM(mode, E, arg, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7) \
+        _BUS_PORT_ITEM(mode, F, arg, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7) \
+        _BUS_PORT_ITEM(mode, G, arg, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7) \
+        _BUS_PORT_ITEM(mode, H, arg, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7) \
+        _BUS_PORT_ITEM(mode, I, arg, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7) \
+        _BUS_PORT_ITEM(mode, J, arg, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7) \
+        _BUS_PORT_ITEM(mode, K, arg, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7) \
+        _BUS_PORT_ITEM(mode, L, arg, pin0, pin1, pin2, pin3, pin4, pin5, pin6, pin7) \
+
+#define _BUS7(mode, arg, pin0, pin1, pin2, pin3, pin4, pin5, pin6) \
+    _BUS8(mode, arg, pin0, pin1, pin2, pin3, pin4, pin5, pin6, NOT_A_PIN)
+
+#define _BUS6(mode, arg, pin0, pin1, pin2, pin3, pin4, pin5) \
+    _BUS8(mode, arg, pin0, pin1, pin2, pin3, pin4, pin5, NOT_A_PIN, NOT_A_PIN)
+
+#define _BUS5(mode, arg, pin0, pin1, pin2, pin3, pin4) \
+    _BUS8(mode, arg, pin0, pin1, pin2, pin3, pin4, NOT_A_PIN, NOT_A_PIN, NOT_A_PIN)
+
+#define _BUS4(mode, arg, pin0, pin1, pin2, pin3) \
+    _BUS8(mode, arg, pin0, pin1, pin2, pin3, NOT_A_PIN, NOT_A_PIN, NOT_A_PIN, NOT_A_PIN)
+
+#define _BUS3(mode, arg, pin0, pin1, pin2) \
+    _BUS8(mode, arg, pin0, pin1, pin2, NOT_A_PIN, NOT_A_PIN, NOT_A_PIN, NOT_A_PIN, NOT_A_PIN)
+
+#define _BUS2(mode, arg, pin0, pin1) \
+    _BUS8(mode, arg, pin0, pin1, NOT_A_PIN, NOT_A_PIN, NOT_A_PIN, NOT_A_PIN, NOT_A_PIN, NOT_A_PIN)
+
+#define _BUS1(mode, arg, pin0) \
+    _BUS8(mode, arg, pin0, NOT_A_PIN, NOT_A_PIN, NOT_A_PIN, NOT_A_PIN, NOT_A_PIN, NOT_A_PIN, NOT_A_PIN)
+
+#define _BUS(mode, arg, ...)           \
+    GET_MACRO8(__VA_ARGS__,            \
+               _BUS8,                  \
+               _BUS7,                  \
+               _BUS6,                  \
+               _BUS5,                  \
+               _BUS4,                  \
+               _BUS3,                  \
+               _BUS2,                  \
+               _BUS1)(mode, arg, __VA_ARGS__)
+
+/* Write value to the bus given by pins (1 .. 8 pins) */
+#define BUS_WRITE(value, ...)                           \
+    do {                                                \
+        uint8_t _bus_value = (value);                   \
+        _BUS(WRITE, _bus_value, __VA_ARGS__)            \
+    } while (0)
+
+/* BUS_WRITE safe against interrupt routines changing the same ports */
+#define ATOMIC_BUS_WRITE(value, ...)                    \
+    do {                                                \
+        uint8_t _bus_value = (value);                   \
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {             \
+            _BUS(WRITE, _bus_value, __VA_ARGS__)        \
+        }                                               \
+    } while (0)
+
+/* Return value read from the bus given by pins (1 .. 8 pins) */
+#define BUS_READ(...)                                   \
+    ({                                                  \
+        uint8_t _bus_result = 0;                        \
+        _BUS(READ, _bus_result, __VA_ARGS__)            \
+        _bus_result;                                    \
+    })
+
+
 extern const ioreg_t PROGMEM port_to_input_PGM[];
 extern void pinMode(uint8_t pin, uint8_t mode);
 extern void digitalWrite(uint8_t pin, uint8_t val);
 extern int digitalRead(uint8_t pin);
 
+
+/* Resolved pin - PIN register address and bit mask.
+   DDR and PORT registers follow the PIN register (see portModeRegister,
+   portOutputRegister). The registers are always 8-bit, so the pointer is
+   uint8_t also on the devices with IO_REG16 (ioreg_t is 16-bit there and
+   reg + 1 would be two bytes after PIN register).
+ */
+typedef struct {
+    volatile uint8_t *reg;  // PIN register
+    uint8_t mask;
+} TPinHandle;
+
+extern TPinHandle pin_resolve(uint8_t pin);
+
+static inline void pin_mode(const TPinHandle *handle, uint8_t mode)
+{
+    volatile uint8_t *ddr = handle->reg + 1;
+    volatile uint8_t *out = handle->reg + 2;
+
+    if (mode == INPUT) {
+        *ddr &= ~handle->mask;
+        *out &= ~handle->mask;
+    } else if (mode == INPUT_PULLUP) {
+        *ddr &= ~handle->mask;
+        *out |= handle->mask;
+    } else {
+        *ddr |= handle->mask;
+    }
+}
+
+static inline void pin_write(const TPinHandle *handle, uint8_t val)
+{
+    if (val == LOW) {
+        *(handle->reg + 2) &= ~handle->mask;
+    } else {
+        *(handle->reg + 2) |= handle->mask;
+    }
+}
+
+static inline uint8_t pin_read(const TPinHandle *handle)
+{
+    return (*handle->reg & handle->mask) ? HIGH : LOW;
+}
+
+static inline void pin_toggle(const TPinHandle *handle)
+{
+    *(handle->reg + 2) ^= handle->mask;
+}
+
+/* The same as pin_mode, pin_write and pin_toggle, but safe when an interrupt
+   routine changes other pins of the same port (see ATOMIC_DIGITAL_WRITE).
+   PORT bits are toggled by writing the PIN register when AVRIO_PIN_TOGGLE
+   is 1, otherwise the read-modify-write runs with disabled interrupts. */
+static inline void atomic_pin_mode(const TPinHandle *handle, uint8_t mode)
+{
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        pin_mode(handle, mode);
+    }
+}
+
+static inline void atomic_pin_write(const TPinHandle *handle, uint8_t val)
+{
+#if AVRIO_PIN_TOGGLE
+    volatile uint8_t *out = handle->reg + 2;
+
+    if (val == LOW) {
+        *handle->reg = *out & handle->mask;
+    } else {
+        *handle->reg = ~*out & handle->mask;
+    }
+#else
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        pin_write(handle, val);
+    }
+#endif
+}
+
+static inline void atomic_pin_toggle(const TPinHandle *handle)
+{
+#if AVRIO_PIN_TOGGLE
+    *handle->reg = handle->mask;
+#else
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        pin_toggle(handle);
+    }
+#endif
+}
+
 #endif // AVRIO_H_INCLUDED
@@ -0,0 +1,185 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stddef.h>
+#include "avrpcint.h"
+
+/* Older devices have one group with registers GIMSK, GIFR and PCMSK */
+#ifdef PCICR
+  #define _PCICR PCICR
+  #define _PCIFR PCIFR
+#else
+  #define _PCICR GIMSK
+  #define _PCIFR GIFR
+#endif
+
+#if defined(PCMSK) && !defined(PCMSK0)
+  #define _PCMSK0 PCMSK
+  #define _PCIE0  PCIE
+  #define _PCIF0  PCIF
+#else
+  #define _PCMSK0 PCMSK0
+  #define _PCIE0  PCIE0
+  #define _PCIF0  PCIF0
+#endif
+#define _PCMSK1 PCMSK1
+#define _PCIE1  PCIE1
+#define _PCIF1  PCIF1
+#define _PCMSK2 PCMSK2
+#define _PCIE2  PCIE2
+#define _PCIF2  PCIF2
+#define _PCMSK3 PCMSK3
+#define _PCIE3  PCIE3
+#define _PCIF3  PCIF3
+
+typedef struct {
+    uint8_t last;                   // PIN register at the last interrupt
+    volatile uint8_t events;        // changed pins, cleared by pcint_changed
+    TPcintCallback callback[8];
+} TPcintGroup;
+
+/* Process the changed pins of the group */
+static inline void pcint_dispatch(TPcintGroup *group, uint8_t port,
+                                  uint8_t state, uint8_t mask)
+{
+    uint8_t changed = (state ^ group->last) & mask;
+    uint8_t bit = 0;
+
+    group->last = state;
+    group->events |= changed;
+    while (changed) {
+        if ( (changed & 0x01) && (group->callback[bit]) ) {
+            group->callback[bit]((port << 3) | bit, (state >> bit) & 0x01);
+        }
+        changed >>= 1;
+        bit++;
+    }
+}
+
+/* Group variable and interrupt routine for group n */
+#define PCINT_GROUP(n)                                                  \
+    static TPcintGroup _pcint_group##n;                                 \
+                                                                        \
+    ISR (PCINT##n##_vect)                                               \
+    {                                                                   \
+        pcint_dispatch(&_pcint_group##n, CAT(ioPORT, PCINT##n##_PORT),  \
+                       CAT(PIN, PCINT##n##_PORT), _PCMSK##n);           \
+    }
+
+/* Select registers of the group of the port */
+#define PCINT_SELECT(n)                                                 \
+    if (port == CAT(ioPORT, PCINT##n##_PORT)) {                         \
+        item->group = &_pcint_group##n;                                 \
+        item->pcmsk = &_PCMSK##n;                                       \
+        item->pin_reg = &CAT(PIN, PCINT##n##_PORT);                     \
+        item->pcie = _BV(_PCIE##n);                                     \
+        item->pcif = _BV(_PCIF##n);                                     \
+        return 1;                                                       \
+    }
+
+#ifdef PCINT0_PORT
+  PCINT_GROUP(0)
+#endif
+#ifdef PCINT1_PORT
+  PCINT_GROUP(1)
+#endif
+#ifdef PCINT2_PORT
+  PCINT_GROUP(2)
+#endif
+#ifdef PCINT3_PORT
+  PCINT_GROUP(3)
+#endif
+
+typedef struct {
+    TPcintGroup *group;
+    volatile uint8_t *pcmsk;
+    volatile uint8_t *pin_reg;
+    uint8_t pcie;
+    uint8_t pcif;
+} TPcintItem;
+
+/* Find the group of the pin, return False if the port has no group */
+static uint8_t pcint_find(uint8_t pin, TPcintItem *item)
+{
+    uint8_t port = digitalPinToPort(pin);
+
+    #ifdef PCINT0_PORT
+        PCINT_SELECT(0)
+    #endif
+    #ifdef PCINT1_PORT
+        PCINT_SELECT(1)
+    #endif
+    #ifdef PCINT2_PORT
+        PCINT_SELECT(2)
+    #endif
+    #ifdef PCINT3_PORT
+        PCINT_SELECT(3)
+    #endif
+    return 0;
+}
+
+void pcint_attach(uint8_t pin, TPcintCallback callback)
+{
+    TPcintItem item;
+    uint8_t mask = digitalPinToBitMask(pin);
+
+    if (! pcint_find(pin, &item)) {
+        return;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        item.group->callback[digitalPinToBit(pin)] = callback;
+        item.group->events &= ~mask;
+        /* Current value of the pin, the first interrupt reports only a change */
+        item.group->last = (item.group->last & ~mask) | (*item.pin_reg & mask);
+        if (! (*item.pcmsk)) {
+            _PCIFR = item.pcif;         // Clear old pending interrupt
+        }
+        *item.pcmsk |= mask;
+        _PCICR |= item.pcie;
+    }
+}
+
+void pcint_detach(uint8_t pin)
+{
+    TPcintItem item;
+
+    if (! pcint_find(pin, &item)) {
+        return;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        *item.pcmsk &= ~digitalPinToBitMask(pin);
+        if (! (*item.pcmsk)) {
+            _PCICR &= ~item.pcie;
+        }
+        item.group->callback[digitalPinToBit(pin)] = NULL;
+    }
+}
+
+uint8_t pcint_changed(uint8_t pin)
+{
+    TPcintItem item;
+    uint8_t mask = digitalPinToBitMask(pin);
+    uint8_t result;
+
+    if (! pcint_find(pin, &item)) {
+        return 0;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        result = item.group->events & mask;
+        item.group->events &= ~mask;
+    }
+    return result != 0;
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* AVRPCINT library - pin change interrupts for avrio pins.
+
+   Pins are given by avrio numbers (ioPB0, ioPD3, ...). Every pin change
+   interrupt group (PCINT0_vect .. PCINT3_vect) covers one port, the
+   group of the pin is found by its port. The interrupt routine compares
+   the PIN register with its previous value and only the changed pins
+   with enabled interrupt are processed - the event flag of the pin is set
+   and its callback is called.
+
+   The port of each group is given by PCINTn_PORT (port letter) in global.h.
+   Defaults are set for ATmega48/88/168/328, ATmega164/324/644/1284,
+   ATmega640/1280/2560 (groups 0 and 2) and ATtiny25/45/85. Groups which
+   contain pins of several ports (e.g. PCINT1 of ATmega2560) are not
+   supported.
+       #define PCINT0_PORT B
+       #define PCINT2_PORT D
+
+   Pin change interrupt wakes up the CPU from all sleep modes, so the
+   program can sleep until the next input edge instead of polling.
+
+   Example:
+       static void on_button(uint8_t pin, uint8_t value) {
+           ...                 // called from the interrupt routine
+       }
+
+       pinMode(ioPD2, INPUT_PULLUP);
+       pcint_attach(ioPD2, on_button);
+       pcint_attach(ioPD3, NULL);          // event flag only
+       sei();
+       while (1) {
+           if (pcint_changed(ioPD3)) {
+               ...
+           }
+           sleep_mode();
+       }
+*/
+
+#ifndef AVRPCINT_H_INCLUDED
+#define AVRPCINT_H_INCLUDED
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "preprocessor.h"
+#include "avrio.h"
+#include "global.h"
+
+#if !defined(PCINT0_PORT) && !defined(PCINT1_PORT) && \
+    !defined(PCINT2_PORT) && !defined(PCINT3_PORT)
+  #if defined(__AVR_ATmega48__) || defined(__AVR_ATmega48A__) ||       \
+      defined(__AVR_ATmega48P__) || defined(__AVR_ATmega48PA__) ||     \
+      defined(__AVR_ATmega88__) || defined(__AVR_ATmega88A__) ||       \
+      defined(__AVR_ATmega88P__) || defined(__AVR_ATmega88PA__) ||     \
+      defined(__AVR_ATmega168__) || defined(__AVR_ATmega168A__) ||     \
+      defined(__AVR_ATmega168P__) || defined(__AVR_ATmega168PA__) ||   \
+      defined(__AVR_ATmega328__) || defined(__AVR_ATmega328P__)
+    #define PCINT0_PORT B
+    #define PCINT1_PORT C
+    #define PCINT2_PORT D
+  #elif defined(__AVR_ATmega164A__) || defined(__AVR_ATmega164P__) ||  \
+      defined(__AVR_ATmega164PA__) || defined(__AVR_ATmega324A__) ||   \
+      defined(__AVR_ATmega324P__) || defined(__AVR_ATmega324PA__) ||   \
+      defined(__AVR_ATmega644__) || defined(__AVR_ATmega644A__) ||     \
+      defined(__AVR_ATmega644P__) || defined(__AVR_ATmega644PA__) ||   \
+      defined(__AVR_ATmega1284__) || defined(__AVR_ATmega1284P__)
+    #define PCINT0_PORT A
+    #define PCINT1_PORT B
+    #define PCINT2_PORT C
+    #define PCINT3_PORT D
+  #elif defined(__AVR_ATmega640__) || defined(__AVR_ATmega1280__) ||   \
+      defined(__AVR_ATmega2560__)
+    #define PCINT0_PORT B
+    #define PCINT2_PORT K
+  #elif defined(__AVR_ATtiny25__) || defined(__AVR_ATtiny45__) ||      \
+      defined(__AVR_ATtiny85__)
+    #define PCINT0_PORT B
+  #else
+    #error Pin change interrupt ports are not known for this device, define PCINTn_PORT in global.h
+  #endif
+#endif
+
+/* Called from the interrupt routine with the pin number and its new value */
+typedef void (*TPcintCallback)(uint8_t pin, uint8_t value);
+
+/* Enable pin change interrupt of the pin. Callback can be NULL, the change
+ * is then only signalled by pcint_changed. The pin mode is not changed.
+ */
+extern void pcint_attach(uint8_t pin, TPcintCallback callback);
+
+/* Disable pin change interrupt of the pin */
+extern void pcint_detach(uint8_t pin);
+
+/* Return True if the pin changed since the last call, the flag is cleared */
+extern uint8_t pcint_changed(uint8_t pin);
+
+#endif // AVRPCINT_H_INCLUDED
@@ -115,7 +115,7 @@ typedef struct  {
    uint8_t displaymode : 2;
 
    TDisplayType type;
-   uint8_t pin_enable;
+   TPinHandle enable;      // Enable pin resolved by pin_resolve
    uint8_t ddram_address;
    const char* send_text;  // Pointer to sended text data
    uint16_t wait_start;    // Start of time measurement
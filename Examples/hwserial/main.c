@@ -53,7 +53,7 @@ ISR (TIMER0_OVF_vect) {
 static uint8_t update_serial(struct pt *pt)
 {
   PT_BEGIN(pt); 
-  PT_WAIT_UNTIL(pt, usart_available() >= 3);
+  PT_USART_WAIT_RX(pt, usart, 3);
   
   //Suppress line endings
   if ( usart_readstr_P(PSTR("\n")) || usart_readstr_P(PSTR("\r")) ) 
@@ -61,7 +61,7 @@ static uint8_t update_serial(struct pt *pt)
   
 
   if ( usart_readstr_P(PSTR("LED")) ) {
-    PT_WAIT_UNTIL(pt, usart_available() >= 2); //Expected: "A0", "A1"
+    PT_USART_WAIT_RX(pt, usart, 2); //Expected: "A0", "A1"
     
     char led = usart_getchar();
     uint8_t state = usart_getchar() - '0';
@@ -77,14 +77,14 @@ static uint8_t update_serial(struct pt *pt)
         DIGITAL_WRITE(LED_C, state);
         break;
       default:
-        usart_print_P(PSTR("Unknown command\n"));
-        PT_WAIT_UNTIL(pt, usart_tx_empty());
+        PT_USART_PRINT_P(pt, usart, PSTR("Unknown command\n"));
+        PT_USART_WAIT_TX(pt, usart);
         usart_clear();
         PT_RESTART(pt);
     }
   } else {
-    usart_print_P(PSTR("Unknown command\n"));
-    PT_WAIT_UNTIL(pt, usart_tx_empty());
+    PT_USART_PRINT_P(pt, usart, PSTR("Unknown command\n"));
+    PT_USART_WAIT_TX(pt, usart);
     usart_clear();
     PT_RESTART(pt);
   }
@@ -96,9 +96,8 @@ static uint8_t process_buttons(struct pt *pt)
 {
   PT_BEGIN(pt); 
   if (button_pressed(&btnA) ) {
-     usart_print_P(PSTR("BUTTON PRESSED\n"));
      DIGITAL_WRITE(LED_C, ! digitalRead(LED_C) );
-     PT_WAIT_UNTIL(pt, usart_tx_empty());
+     PT_USART_PRINT_P(pt, usart, PSTR("BUTTON PRESSED\n"));
   }
   PT_END(pt);
 }
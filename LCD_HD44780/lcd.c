@@ -54,7 +54,7 @@ void lcd_init(TLcd *lcd, uint8_t pin_enable, TDisplayType lcd_type)
     lcd->send_text = NULL;
     lcd->ddram_address = 0;
     lcd->type = lcd_type;
-    lcd->pin_enable = pin_enable;
+    lcd->enable = pin_resolve(pin_enable);
 
     if ((lcd_type == LCD_TYPE_2LINE) || (lcd_type == LCD_TYPE_1X16)) {
          displayfunction |= LCD_2LINE;
@@ -69,8 +69,8 @@ void lcd_init(TLcd *lcd, uint8_t pin_enable, TDisplayType lcd_type)
         PINMODE(LCD_PIN_RW, OUTPUT);
     #endif // LCD_PIN_RW
 
-    pinMode(lcd->pin_enable, OUTPUT);
-    digitalWrite(lcd->pin_enable, LOW);
+    atomic_pin_mode(&lcd->enable, OUTPUT);
+    atomic_pin_write(&lcd->enable, LOW);
     lcd_setWriteMode(lcd); //Write to LCD
 
     _delay_ms(50);
@@ -350,32 +350,23 @@ void lcd_send(TLcd *lcd, uint8_t value, uint8_t mode) {
 
 #ifdef LCD_IS_4BITMODE
 static void write4bits(TLcd *lcd, uint8_t value) {
-    DIGITAL_WRITE(LCD_PIN_D4, (value & _BV(0)) );
-    DIGITAL_WRITE(LCD_PIN_D5, (value & _BV(1)) );
-    DIGITAL_WRITE(LCD_PIN_D6, (value & _BV(2)) );
-    DIGITAL_WRITE(LCD_PIN_D7, (value & _BV(3)) );
+    ATOMIC_BUS_WRITE(value, LCD_PIN_D4, LCD_PIN_D5, LCD_PIN_D6, LCD_PIN_D7);
     pulseEnable(lcd);
 }
 #endif // LCD_IS_4BITMODE
 
 #ifdef LCD_IS_8BITMODE
 static void write8bits(TLcd *lcd, uint8_t value) {
-    DIGITAL_WRITE(LCD_PIN_D0, (value & _BV(0)) );
-    DIGITAL_WRITE(LCD_PIN_D1, (value & _BV(1)) );
-    DIGITAL_WRITE(LCD_PIN_D2, (value & _BV(2)) );
-    DIGITAL_WRITE(LCD_PIN_D3, (value & _BV(3)) );
-    DIGITAL_WRITE(LCD_PIN_D4, (value & _BV(4)) );
-    DIGITAL_WRITE(LCD_PIN_D5, (value & _BV(5)) );
-    DIGITAL_WRITE(LCD_PIN_D6, (value & _BV(6)) );
-    DIGITAL_WRITE(LCD_PIN_D7, (value & _BV(7)) );
+    ATOMIC_BUS_WRITE(value, LCD_PIN_D0, LCD_PIN_D1, LCD_PIN_D2, LCD_PIN_D3,
+                            LCD_PIN_D4, LCD_PIN_D5, LCD_PIN_D6, LCD_PIN_D7);
     pulseEnable(lcd);
 }
 #endif // LCD_IS_8BITMODE
 
 static void pulseEnable(TLcd *lcd) {
-    digitalWrite(lcd->pin_enable, HIGH);
+    atomic_pin_write(&lcd->enable, HIGH);
     _delay_us(1);    // enable pulse must be >450ns
-    digitalWrite(lcd->pin_enable, LOW);
+    atomic_pin_write(&lcd->enable, LOW);
 }
 
 
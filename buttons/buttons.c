@@ -20,7 +20,7 @@
 void button_init(TButtonState *button_state, uint8_t pin, uint8_t mode)
 {
   button_state->state_all = 0;
-  button_state->pin = pin;
+  button_state->pin = pin_resolve(pin);
   button_state->last_time = time0;
   #if BTN_PRESSED == 0
     button_state->state = 1;
@@ -28,7 +28,7 @@ void button_init(TButtonState *button_state, uint8_t pin, uint8_t mode)
     button_state->state = 0;
   #endif
 
-  pinMode(pin, mode);
+  atomic_pin_mode(&button_state->pin, mode);
 }
 
 void button_update(TButtonState *button_state)
@@ -37,7 +37,7 @@ void button_update(TButtonState *button_state)
    uint16_t debounce_time; 
    uint16_t elapsed_time;
    
-   raw_state = digitalRead(button_state->pin);
+   raw_state = pin_read(&button_state->pin);
 
    if (raw_state == button_state->state) {
      elapsed_time = time0 - button_state->last_time;
@@ -103,7 +103,7 @@ typedef struct {
      };
      uint8_t state_all; 
    };
-   uint8_t pin;                           // Button pin number defined in avrio library      
+   TPinHandle pin;                        // Button pin resolved by pin_resolve
    volatile uint16_t last_time;           // Event time measurement
 } TButtonState;
 
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <util/atomic.h>
+#include "binlog.h"
+
+static uint8_t binlog_dropped_count;
+
+void binlog_write(const char *fmt, const void *args, uint8_t len)
+{
+  uint16_t id = (uint16_t) (uintptr_t) fmt;
+  char header[3];
+  uint8_t pos;
+
+  header[0] = id & 0xFF;
+  header[1] = id >> 8;
+  header[2] = len;
+
+  /* Only the reservation runs with disabled interrupts, the message is 
+   * copied with enabled interrupts. Messages from interrupt routines 
+   * reserve the space behind it and they are sent after this one.
+   */
+  if (_binlog_usart_function(tx_reserve)(sizeof(header) + len, &pos)) {
+    pos = _binlog_usart_function(tx_fill)(pos, header, sizeof(header));
+    _binlog_usart_function(tx_fill)(pos, args, len);
+    _binlog_usart_function(tx_commit)();
+  } else {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      if (binlog_dropped_count < 255) {
+        binlog_dropped_count++;
+      }
+    }
+  }
+}
+
+uint8_t binlog_dropped(void)
+{
+  uint8_t count;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    count = binlog_dropped_count;
+    binlog_dropped_count = 0;
+  }
+  return count;
+}
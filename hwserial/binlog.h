@@ -0,0 +1,133 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Binary logging over hwserial.
+ *
+ * Log messages are not formatted by the MCU. The call site sends only 
+ * 16-bit message id and raw binary values of arguments into the TX ring 
+ * buffer of hwserial. The format string is stored in the program memory 
+ * and its address is used as the message id. The tool `binlog_decode.py` 
+ * reads format strings from the firmware ELF file and prints the messages
+ * in the text form.
+ *
+ * Frame format (all values little endian):
+ *    id (2 bytes) | len (1 byte) | arguments (len bytes)
+ *
+ * Example:
+ *    uint8_t channel = 3;
+ *    uint16_t value = adc_read(channel);
+ *    BINLOG("ADC %hhu = %u", channel, value);   // 6 bytes on the wire
+ *
+ *    python binlog_decode.py main.elf /dev/ttyUSB0 115200
+ *
+ * Arguments are stored with their own type (sizeof), not promoted as in 
+ * printf. The format must match: %hhu/%hhd/%hhx/%c for 8-bit values, 
+ * %u/%d/%x for 16-bit values (int), %lu/%ld/%lx for 32-bit values and 
+ * %f for float. Numeric constants are int (16 bits). At most 4 arguments 
+ * are supported, strings (%s) are not supported.
+ *
+ * Configuration in global.h:
+ *   BINLOG_USART - number of used USART (empty or 0 for USART/0, 1, 2, 3). 
+ *                  The USART must have TX buffer (USARTn_TX_BUFFER).
+ *
+ * Logging never waits for the USART. If there is not enough space in the
+ * TX buffer, the message is dropped and counted by binlog_dropped.
+ * Messages can be logged from interrupt routines too.
+ */
+
+#ifndef BINLOG_H_INCLUDED
+#define BINLOG_H_INCLUDED
+
+#include <stddef.h>
+#include <avr/pgmspace.h>
+#include "hwserial.h"
+
+#ifndef BINLOG_USART
+  #define BINLOG_USART
+#endif
+
+/* Function of the hwserial library for the USART BINLOG_USART */
+#if IS_EMPTY_DEF(BINLOG_USART)
+  #define _binlog_usart_function(name) CAT(usart, _ ## name)
+  #define _BINLOG_TX_BUFFER USART_TX_BUFFER
+#elif BINLOG_USART==0
+  #define _binlog_usart_function(name) CAT(usart, _ ## name)
+  #define _BINLOG_TX_BUFFER USART_TX_BUFFER
+#else
+  #define _binlog_usart_function(name) CAT3(usart, BINLOG_USART, _ ## name)
+  #define _BINLOG_TX_BUFFER CAT3(USART, BINLOG_USART, _TX_BUFFER)
+#endif
+
+#if _BINLOG_TX_BUFFER == 0
+  #error Binary log needs TX buffer. Define USARTn_TX_BUFFER for BINLOG_USART.
+#endif
+
+/* Send one message. Use macro BINLOG instead of direct call. */
+extern void binlog_write(const char *fmt, const void *args, uint8_t len);
+
+/* Return number of dropped messages (saturated at 255) and clear the counter */
+extern uint8_t binlog_dropped(void);
+
+/* Log message with 0 - 4 arguments */
+#define BINLOG(fmt, ...)                                                \
+  _BINLOG_SELECT(_0, ## __VA_ARGS__,                                    \
+                 _BINLOG_4, _BINLOG_3, _BINLOG_2, _BINLOG_1, _BINLOG_0  \
+                )(fmt, ## __VA_ARGS__)
+
+#define _BINLOG_SELECT(_0,_1,_2,_3,_4,NAME,...) NAME
+
+/* The name _binlog_fmt is searched by binlog_decode.py, don't change it. */
+#define _BINLOG_FMT(fmt) \
+  static const char _binlog_fmt[] PROGMEM = fmt
+
+#define _BINLOG_ARGS(...)                                               \
+  struct __attribute__((packed)) { __VA_ARGS__ } _binlog_args
+
+#define _BINLOG_0(fmt) do {                                             \
+    _BINLOG_FMT(fmt);                                                   \
+    binlog_write(_binlog_fmt, NULL, 0);                                 \
+  } while (0)
+
+#define _BINLOG_1(fmt, a1) do {                                         \
+    _BINLOG_FMT(fmt);                                                   \
+    _BINLOG_ARGS(__typeof__(a1) v1;) = { (a1) };                        \
+    binlog_write(_binlog_fmt, &_binlog_args, sizeof(_binlog_args));     \
+  } while (0)
+
+#define _BINLOG_2(fmt, a1, a2) do {                                     \
+    _BINLOG_FMT(fmt);                                                   \
+    _BINLOG_ARGS(__typeof__(a1) v1; __typeof__(a2) v2;) =               \
+      { (a1), (a2) };                                                   \
+    binlog_write(_binlog_fmt, &_binlog_args, sizeof(_binlog_args));     \
+  } while (0)
+
+#define _BINLOG_3(fmt, a1, a2, a3) do {                                 \
+    _BINLOG_FMT(fmt);                                                   \
+    _BINLOG_ARGS(__typeof__(a1) v1; __typeof__(a2) v2;                  \
+                 __typeof__(a3) v3;) =                                  \
+      { (a1), (a2), (a3) };                                             \
+    binlog_write(_binlog_fmt, &_binlog_args, sizeof(_binlog_args));     \
+  } while (0)
+
+#define _BINLOG_4(fmt, a1, a2, a3, a4) do {                             \
+    _BINLOG_FMT(fmt);                                                   \
+    _BINLOG_ARGS(__typeof__(a1) v1; __typeof__(a2) v2;                  \
+                 __typeof__(a3) v3; __typeof__(a4) v4;) =               \
+      { (a1), (a2), (a3), (a4) };                                       \
+    binlog_write(_binlog_fmt, &_binlog_args, sizeof(_binlog_args));     \
+  } while (0)
+
+#endif // BINLOG_H_INCLUDED
@@ -0,0 +1,154 @@
+# 
+# Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+# 
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# Decoder of binary log messages sent by binlog.h.
+#
+# Usage: 
+#   python binlog_decode.py firmware.elf [input [baudrate]]
+#
+# Format strings are read from the symbols _binlog_fmt in the ELF file 
+# of the firmware. The input is a file with captured data, a serial port
+# (baudrate is required, pyserial module is used) or standard input 
+# when it is not specified.
+
+from __future__ import print_function
+import re
+import struct
+import sys
+
+SYMBOL_RE = re.compile(r"^_binlog_fmt(\.\d+)?$")
+
+# printf conversion: flags, width, precision, length, conversion
+FORMAT_RE = re.compile(r"%([-+ #0]*)(\d*)(\.\d+)?(hh|h|ll|l)?([diouxXcfeEgGp%])")
+
+SIZES = {"hh": 1, "h": 2, "": 2, "l": 4, "ll": 8}
+
+
+def read_elf_formats(file_name):
+    """Return dictionary: message id -> format string"""
+    data = open(file_name, "rb").read()
+    if data[:4] != b"\x7fELF" or data[4:5] != b"\x01":
+        sys.exit("%s: 32-bit ELF file expected" % (file_name,))
+    endian = "<" if data[5:6] == b"\x01" else ">"
+    (shoff, ) = struct.unpack_from(endian + "I", data, 0x20)
+    shentsize, shnum = struct.unpack_from(endian + "HH", data, 0x2E)
+
+    sections = []
+    for i in range(shnum):
+        sections.append(struct.unpack_from(endian + "IIIIIIIIII", data, shoff + i * shentsize))
+    # name, type, flags, addr, offset, size, link, info, addralign, entsize
+
+    formats = {}
+    for section in sections:
+        if section[1] != 2:     # SHT_SYMTAB
+            continue
+        strtab = sections[section[6]]
+        for pos in range(section[4], section[4] + section[5], 16):
+            name, value, size, info, other, shndx = struct.unpack_from(endian + "IIIBBH", data, pos)
+            name_pos = strtab[4] + name
+            name = data[name_pos:data.index(b"\0", name_pos)].decode("ascii", "replace")
+            if not SYMBOL_RE.match(name) or not (0 < shndx < len(sections)):
+                continue
+            target = sections[shndx]
+            text_pos = target[4] + value - target[3]
+            text = data[text_pos:data.index(b"\0", text_pos)].decode("latin-1")
+            formats[value & 0xFFFF] = text
+    return formats
+
+
+def format_args(fmt):
+    """Return list of (conversion, size) for arguments of the format"""
+    args = []
+    for m in FORMAT_RE.finditer(fmt):
+        length, conversion = m.group(4) or "", m.group(5)
+        if conversion == "%":
+            continue
+        if conversion == "c":
+            size = 1
+        elif conversion in "feEgG":
+            size = 4
+        else:
+            size = SIZES[length]
+        args.append((conversion, size))
+    return args
+
+
+def decode_value(conversion, data):
+    if conversion in "feEgG":
+        return struct.unpack("<f", data)[0]
+    code = {1: "b", 2: "h", 4: "i", 8: "q"}[len(data)]
+    if conversion not in "di":
+        code = code.upper()
+    value = struct.unpack("<" + code, data)[0]
+    if conversion == "c":
+        return chr(value)
+    return value
+
+
+def format_message(fmt, args, data):
+    values = []
+    pos = 0
+    for conversion, size in args:
+        values.append(decode_value(conversion, data[pos:pos + size]))
+        pos += size
+    # Python does not know length modifiers
+    return FORMAT_RE.sub(lambda m: "%" + (m.group(1) or "") + m.group(2) + (m.group(3) or "") + 
+                         (m.group(5) if m.group(5) != "p" else "x"), fmt) % tuple(values)
+
+
+def decode(formats, stream):
+    messages = dict((msg_id, (fmt, format_args(fmt))) for msg_id, fmt in formats.items())
+    buf = bytearray()
+    while True:
+        chunk = stream.read(1)
+        if not chunk:
+            break
+        buf += chunk
+        while len(buf) >= 3:
+            msg_id = buf[0] | (buf[1] << 8)
+            length = buf[2]
+            message = messages.get(msg_id)
+            if message is None or sum(size for c, size in message[1]) != length:
+                # Lost synchronization - skip one byte
+                print("?? %02X" % (buf[0],), file=sys.stderr)
+                del buf[0]
+                continue
+            if len(buf) < 3 + length:
+                break
+            print(format_message(message[0], message[1], bytes(buf[3:3 + length])))
+            sys.stdout.flush()
+            del buf[:3 + length]
+
+
+def main():
+    if len(sys.argv) not in (2, 3, 4):
+        sys.exit("Usage: python binlog_decode.py firmware.elf [input [baudrate]]")
+    formats = read_elf_formats(sys.argv[1])
+    if not formats:
+        sys.exit("No binlog messages found in %s" % (sys.argv[1],))
+
+    if len(sys.argv) == 4:
+        import serial
+        stream = serial.Serial(sys.argv[2], int(sys.argv[3]))
+    elif len(sys.argv) == 3:
+        stream = open(sys.argv[2], "rb")
+    else:
+        stream = getattr(sys.stdin, "buffer", sys.stdin)
+    decode(formats, stream)
+
+
+if __name__ == "__main__":
+    main()
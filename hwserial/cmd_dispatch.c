@@ -0,0 +1,82 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include "cmd_dispatch.h"
+
+void cmd_init(TCmdDispatcher *cmd, const TCmdNode *nodes, const TCmdHandler *handlers)
+{
+  cmd->nodes = nodes;
+  cmd->handlers = handlers;
+  cmd->state = 0;
+}
+
+/* Find edge of the node for character ch, return NULL if there is none.
+ * Then *end is the terminating item of the node with the failure link.
+ */
+static const TCmdNode *cmd_edge(const TCmdNode *node, char ch, const TCmdNode **end)
+{
+  char node_ch;
+
+  while ( (node_ch = pgm_read_byte(&node->ch)) != '\0' ) {
+    if (node_ch == ch) {
+      return node;
+    }
+    node++;
+  }
+  *end = node;
+  return NULL;
+}
+
+uint8_t cmd_feed(TCmdDispatcher *cmd, char ch)
+{
+  uint16_t state = cmd->state;
+  const TCmdNode *node, *end = NULL;
+  uint8_t command;
+
+  /* The character which does not continue the command is tried in the 
+     node of the longest received suffix (e.g. "AAAB" finds "AAB") */
+  while ( (node = cmd_edge(cmd->nodes + state, ch, &end)) == NULL ) {
+    if (state == 0) {
+      cmd->state = 0;
+      return CMD_NOMATCH;
+    }
+    state = pgm_read_word(&end->next);     // failure link
+  }
+  command = pgm_read_byte(&node->command);
+  if (command) {
+    cmd->state = 0;     // Whole command received
+    return command;
+  }
+  cmd->state = pgm_read_word(&node->next);
+  return CMD_PENDING;
+}
+
+uint8_t cmd_dispatch(TCmdDispatcher *cmd, char ch)
+{
+  uint8_t command;
+  TCmdHandler handler;
+
+  command = cmd_feed(cmd, ch);
+  if ( (command != CMD_PENDING) && (command != CMD_NOMATCH) && 
+       (cmd->handlers != NULL) ) {
+    handler = (TCmdHandler) pgm_read_word(&cmd->handlers[command-1]);
+    if (handler != NULL) {
+      handler();
+    }
+  }
+  return command;
+}
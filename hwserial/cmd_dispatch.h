@@ -0,0 +1,113 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Command dispatcher for text commands received by hwserial.
+ *
+ * The list of commands is converted by the tool `cmd_dispatch_h.py` into
+ * a trie table stored in the program memory. Received characters are 
+ * passed one by one to the function cmd_feed, which walks the trie and 
+ * returns number of the command when the whole command is received. 
+ * Every character is compared with the edges of one trie node (the 
+ * characters which can follow the received prefix), so the time depends 
+ * on the number of these edges, not on the length of the command list.
+ * A character which does not continue the command is tried again in the 
+ * node of the longest suffix of the received characters which is a prefix 
+ * of some command (Aho-Corasick failure links generated by the tool), 
+ * e.g. command "AAB" is recognized in "AAAB".
+ *
+ * Example - file commands.txt (command, optional handler function):
+ *    LED     cmd_led
+ *    STATUS  cmd_status
+ *
+ * python cmd_dispatch_h.py commands.txt commands.h commands
+ *
+ *    #include "commands.h"
+ *    static TCmdDispatcher cmd;
+ *    static uint8_t unknown;
+ *
+ *    cmd_init(&cmd, commands_nodes, commands_handlers);
+ *    while (usart_available()) {
+ *      ch = usart_getchar();
+ *      if (ch == '\n') {
+ *        if (unknown) {
+ *          usart_print_P(PSTR("Unknown command\n"));
+ *        }
+ *        unknown = 0;
+ *        cmd_reset(&cmd);
+ *      } else if (cmd_dispatch(&cmd, ch) == CMD_NOMATCH) {
+ *        unknown = 1;
+ *      }
+ *    }
+ *
+ * The generated header defines constants CMD_<COMMAND> with the command
+ * numbers, which are returned by cmd_feed and cmd_dispatch.
+ * The command cannot be prefix of other command (e.g. "LED" and "LEDS"),
+ * because the command is recognized immediately after its last character.
+ * A command which is inside other command (e.g. "BC" and "ABCD") is not 
+ * recognized while the longer one is being received ("ABC" is pending).
+ */
+
+#ifndef CMD_DISPATCH_H_INCLUDED
+#define CMD_DISPATCH_H_INCLUDED
+
+#include <stddef.h>
+#include <avr/pgmspace.h>
+#include <avr/../inttypes.h>
+
+/* Values returned by cmd_feed and cmd_dispatch. Other values are numbers 
+ * of recognized commands (1 .. 254)
+ */
+#define CMD_PENDING 0       // Beginning of some command, wait for next character
+#define CMD_NOMATCH 255     // Unknown command, the dispatcher is restarted
+
+typedef void (*TCmdHandler)(void);
+
+/* One edge of the trie. Edges of one trie node are stored one after
+ * another and the list is terminated by an item with ch == '\0', its next
+ * is the failure link - the node to continue when no edge matches.
+ */
+typedef struct {
+  char ch;              // Character of the edge
+  uint8_t command;      // Command number if the edge finish the command, otherwise 0
+  uint16_t next;        // Index of the first edge of the next node
+} TCmdNode;
+
+typedef struct {
+  const TCmdNode *nodes;         // Trie table in the program memory
+  const TCmdHandler *handlers;   // Table of handlers in the program memory, can be NULL
+  uint16_t state;                // Index of the first edge of the current node
+} TCmdDispatcher;
+
+/* Initialize dispatcher with tables generated by cmd_dispatch_h.py */
+extern void cmd_init(TCmdDispatcher *cmd, const TCmdNode *nodes, const TCmdHandler *handlers);
+
+/* Start recognition of the new command - forget received characters */
+static inline void cmd_reset(TCmdDispatcher *cmd)
+{
+  cmd->state = 0;
+}
+
+/* Process one received character. Return CMD_PENDING, CMD_NOMATCH or number 
+ * of the recognized command.
+ */
+extern uint8_t cmd_feed(TCmdDispatcher *cmd, char ch);
+
+/* Same as cmd_feed, but the handler of the recognized command is called 
+ * before the function returns.
+ */
+extern uint8_t cmd_dispatch(TCmdDispatcher *cmd, char ch);
+
+#endif // CMD_DISPATCH_H_INCLUDED
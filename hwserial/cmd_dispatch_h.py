@@ -0,0 +1,188 @@
+# 
+# Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+# 
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# Generate trie table for cmd_dispatch.h from the list of commands.
+#
+# Usage: 
+#   python cmd_dispatch_h.py commands.txt commands.h [prefix]
+#
+# Every line of the input file contains the command and optionally name 
+# of the handler function (void handler(void)). Empty lines and lines 
+# starting with '#' are ignored. Escape sequences (\r, \n, \t, \xNN) can be 
+# used in the command.
+
+from __future__ import print_function
+import re
+import sys
+
+MAX_COMMANDS = 254
+
+
+def unescape(text):
+    return re.sub(r"\\(x[0-9a-fA-F]{2}|.)", 
+                  lambda m: chr(int(m.group(1)[1:], 16)) if m.group(1)[0] == "x" 
+                            else {"n": "\n", "r": "\r", "t": "\t"}.get(m.group(1), m.group(1)),
+                  text)
+
+
+def c_char(ch):
+    if ch == "\0":
+        return "'\\0'"
+    if ch == "'" or ch == "\\":
+        return "'\\%s'" % (ch,)
+    if 32 <= ord(ch) < 127:
+        return "'%s'" % (ch,)
+    return "'\\x%02X'" % (ord(ch),)
+
+
+def read_commands(file_name):
+    commands = []
+    with open(file_name) as f:
+        for line_no, line in enumerate(f, 1):
+            items = line.split()
+            if (not items) or items[0].startswith("#"):
+                continue
+            if len(items) > 2:
+                sys.exit("%s:%d: expected command and handler name" % (file_name, line_no))
+            command = unescape(items[0])
+            handler = items[1] if len(items) == 2 else None
+            commands.append((command, handler))
+    return commands
+
+
+def const_name(command):
+    name = re.sub(r"[^A-Z0-9]", "_", command.upper()).strip("_")
+    return "CMD_" + (name or "X%02X" % ord(command[0]))
+
+
+def build_trie(commands):
+    # node is a dictionary: character -> (child node or command number)
+    root = {}
+    for number, (command, handler) in enumerate(commands, 1):
+        node = root
+        for i, ch in enumerate(command):
+            last = (i == len(command) - 1)
+            item = node.get(ch)
+            if last:
+                if item is not None:
+                    sys.exit("Command '%s' is prefix of other command or duplicate" % (command,))
+                node[ch] = number
+            else:
+                if isinstance(item, int):
+                    sys.exit("Command '%s' has prefix '%s' which is other command" 
+                             % (command, command[:i+1]))
+                if item is None:
+                    item = node[ch] = {}
+                node = item
+    return root
+
+
+def trie_table(root):
+    # Nodes are stored in breadth first order, edges of every node are 
+    # terminated by zero item. The terminator holds the failure link - 
+    # the node of the longest proper suffix of the node prefix which is 
+    # also a prefix of some command (Aho-Corasick).
+    nodes = [root]
+    index = {}
+    fail = {id(root): root}
+    position = 0
+    i = 0
+    while i < len(nodes):
+        node = nodes[i]
+        index[id(node)] = position
+        position += len(node) + 1
+        for ch in sorted(node):
+            child = node[ch]
+            if isinstance(child, dict):
+                target = root
+                if node is not root:
+                    target = fail[id(node)]
+                    while not isinstance(target.get(ch), dict) and target is not root:
+                        target = fail[id(target)]
+                    target = target[ch] if isinstance(target.get(ch), dict) else root
+                fail[id(child)] = target
+                nodes.append(child)
+        i += 1
+
+    table = []
+    for node in nodes:
+        for ch in sorted(node):
+            item = node[ch]
+            if isinstance(item, int):
+                table.append((ch, item, 0))
+            else:
+                table.append((ch, 0, index[id(item)]))
+        table.append(("\0", 0, index[id(fail[id(node)])]))
+    return table
+
+
+def main():
+    if len(sys.argv) not in (3, 4):
+        sys.exit("Usage: python cmd_dispatch_h.py commands.txt output.h [prefix]")
+    in_file, out_name = sys.argv[1], sys.argv[2]
+    prefix = sys.argv[3] if len(sys.argv) == 4 else "commands"
+
+    commands = read_commands(in_file)
+    if not commands:
+        sys.exit("No command defined")
+    if len(commands) > MAX_COMMANDS:
+        sys.exit("Too many commands, maximum is %d" % (MAX_COMMANDS,))
+    for command, handler in commands:
+        if "\0" in command:
+            sys.exit("Command cannot contain zero character")
+
+    names = [const_name(command) for command, handler in commands]
+    if len(set(names)) != len(names):
+        sys.exit("Commands must have unique constant names: %s" % (", ".join(names),))
+
+    table = trie_table(build_trie(commands))
+    if len(table) > 0xFFFF:
+        sys.exit("Trie table is too big")
+
+    guard = re.sub(r"[^A-Z0-9]", "_", out_name.upper().split("/")[-1]) + "_INCLUDED"
+    out = open(out_name, "w")
+    out.write("/* This code was generated by cmd_dispatch_h.py tool from the file %s.\n" % (in_file,))
+    out.write("   Please don't update this file manually.\n")
+    out.write(" */\n")
+    out.write("#ifndef %s\n#define %s\n\n" % (guard, guard))
+    out.write('#include "cmd_dispatch.h"\n\n')
+
+    for number, name in enumerate(names, 1):
+        out.write("#define %s %d\n" % (name, number))
+    out.write("\n")
+
+    handlers = sorted(set(handler for command, handler in commands if handler))
+    for handler in handlers:
+        out.write("extern void %s(void);\n" % (handler,))
+    if handlers:
+        out.write("\n")
+
+    out.write("static const TCmdNode %s_nodes[] PROGMEM = {\n" % (prefix,))
+    for ch, command, next_index in table:
+        out.write("  {%s, %d, %d},\n" % (c_char(ch), command, next_index))
+    out.write("};\n\n")
+
+    out.write("static const TCmdHandler %s_handlers[] PROGMEM = {\n" % (prefix,))
+    for command, handler in commands:
+        out.write("  %s,\n" % (handler or "NULL",))
+    out.write("};\n\n")
+
+    out.write("#endif // %s\n" % (guard,))
+    out.close()
+
+
+if __name__ == "__main__":
+    main()
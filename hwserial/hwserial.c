@@ -15,9 +15,443 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #define HWUSART_IMPLEMENTATION
 #include "hwserial.h"
 
 #undef HWUSART_IMPLEMENTATION
 
+
+/* Powers of ten for the digit extraction, the last digit is the remainder */
+static const uint32_t hwusart_pow10[9] PROGMEM = {
+  1000000000UL, 100000000UL, 10000000UL, 1000000UL, 100000UL, 
+  10000UL, 1000UL, 100UL, 10UL
+};
+
+void hwusart_format_dec(TUsartPutchar put, uint32_t value, 
+                        uint8_t digits, uint8_t decimals)
+{
+  const uint32_t *pow = hwusart_pow10 + (10 - digits);
+  uint8_t print = 0;
+  uint32_t p;
+  char ch;
+
+  if (decimals >= digits) {
+    /* All digits are behind the decimal point (e.g. 5, 3 -> "0.005") */
+    put('0');
+    put('.');
+    for (; decimals > digits; decimals--) {
+      put('0');
+    }
+  }
+  for (; digits > 1; digits--) {
+    p = pgm_read_dword(pow++);
+    ch = '0';
+    while (value >= p) {
+      value -= p;
+      ch++;
+    }
+    if ( (ch != '0') || (digits <= decimals + 1) ) {
+      print = 1;
+    }
+    if (print) {
+      put(ch);
+    }
+    if (digits == decimals + 1) {
+      put('.');
+    }
+  }
+  put('0' + (uint8_t) value);
+}
+
+void hwusart_format_int(TUsartPutchar put, int32_t value, uint8_t decimals)
+{
+  if (value < 0) {
+    put('-');
+    hwusart_format_dec(put, - (uint32_t) value, 10, decimals);
+  } else {
+    hwusart_format_dec(put, value, 10, decimals);
+  }
+}
+
+void hwusart_format_hex(TUsartPutchar put, uint32_t value, uint8_t digits)
+{
+  uint8_t nibble;
+
+  while (digits > 0) {
+    digits--;
+    nibble = (value >> (digits * 4)) & 0x0F;
+    put( (nibble < 10) ? ('0' + nibble) : ('A' - 10 + nibble) );
+  }
+}
+
+
+/* Standard baud rates for autobaud */
+static const uint32_t hwusart_baud_rates[] PROGMEM = {
+  1200, 2400, 4800, 9600, 14400, 19200, 28800, 38400, 57600, 
+  76800, 115200, 230400, 250000, 500000, 1000000
+};
+
+uint32_t hwusart_autobaud_rate(const uint16_t *edges)
+{
+  /* Ticks of 8 CPU cycles, 8 bit times - one bit time in CPU cycles */
+  uint16_t period = edges[4] - edges[0];
+  uint16_t interval;
+  uint32_t baud, rate;
+  uint8_t i;
+
+  if (period == 0) {
+    return 0;
+  }
+  /* Every interval must be 2 bit times (+- 1/2 bit time) */
+  for (i = 0; i < 4; i++) {
+    interval = edges[i + 1] - edges[i];
+    if ( (interval * 4UL + period / 4 < period) || 
+         (interval * 4UL > period + period / 4) ) 
+    {
+      return 0;
+    }
+  }
+
+  baud = (F_CPU + period / 2) / period;
+  for (i = 0; i < sizeof(hwusart_baud_rates) / sizeof(hwusart_baud_rates[0]); i++) {
+    rate = pgm_read_dword(&hwusart_baud_rates[i]);
+    if ( (baud + rate / 32 >= rate) && (baud <= rate + rate / 32) ) {
+      return rate;
+    }
+  }
+  return baud;
+}
+
+#ifdef USART_IDLE_SLEEP
+void hwusart_idle(volatile uint8_t *ucsrb, uint8_t udrie)
+{
+  uint8_t mode;
+
+  if (bit_is_clear(SREG, SREG_I)) {
+    return;   // Interrupts are disabled, nothing could wake up the CPU
+  }
+  cli();
+  if (*ucsrb & udrie) {
+    /* Sleep mode of the application is restored after the wake-up */
+    mode = _SLEEP_CONTROL_REG & _SLEEP_MODE_MASK;
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_enable();
+    sei();
+    sleep_cpu();   // Instruction after sei is executed before any interrupt
+    cli();
+    sleep_disable();
+    _SLEEP_CONTROL_REG = (_SLEEP_CONTROL_REG & ~_SLEEP_MODE_MASK) | mode;
+  }
+  sei();
+}
+#endif
+
+#ifdef USART_SHARED
+/*****************************************************************************
+                               USART_SHARED
+ *****************************************************************************/
+/* Bit positions are the same for all USARTs, the USART0 names are used */
+#ifdef URSEL0
+  #define _URSEL _BV(URSEL0)
+#else
+  #define _URSEL 0
+#endif
+
+void hwusart_init_ubrr(THWUsartPort *port, uint16_t ubrr, uint8_t use_u2x,
+                       uint8_t data_size, uint8_t parity, uint8_t stopbits)
+{
+  uint8_t ucsrb = 0;
+  uint8_t ucsrc = _URSEL;
+
+  *port->ucsrb = 0;
+  *port->ucsra = use_u2x ? _BV(U2X0) : 0;
+  *port->ubrrh = ubrr >> 8;
+  *port->ubrrl = ubrr;
+
+  switch (data_size) {
+    case 5: 
+      break;
+    case 6: 
+      ucsrc |= _BV(UCSZ00); 
+      break;
+    case 7: 
+      ucsrc |= _BV(UCSZ01);
+      break;
+    case 8: 
+      ucsrc |= _BV(UCSZ01) | _BV(UCSZ00);
+      break;
+    case 9: 
+      ucsrc |= _BV(UCSZ01) | _BV(UCSZ00);
+      ucsrb |= _BV(UCSZ02);
+      break;
+  }
+
+  switch (parity) {
+    case UARTS_PARITY_NONE:   //None parity
+      break;
+    case UARTS_PARITY_EVEN:
+      ucsrc |= _BV(UPM01);
+      break;
+    case UARTS_PARITY_ODD:
+      ucsrc |= _BV(UPM01) | _BV(UPM00);
+      break;
+  }
+
+  if (stopbits == 2) {
+    ucsrc |= _BV(USBS0); 
+  }
+  *port->ucsrc = ucsrc;
+
+  hwusart_clear(port);
+  port->tx_data_text = 0;
+  port->tx_length = 0;
+
+  *port->ucsrb = ucsrb | _BV(RXEN0) | _BV(TXEN0) | _BV(RXCIE0);
+}
+
+void hwusart_init(THWUsartPort *port, unsigned long baud, 
+                  uint8_t data_size, uint8_t parity, uint8_t stopbits)
+{
+  uint8_t use_u2x;
+  uint16_t ubrr = (F_CPU / 8 / baud + 1) / 2 - 1;
+  uint16_t ubrr_u2x = (F_CPU / 4 / baud + 1) / 2 - 1;
+  long error, error_u2x;
+
+  // U2X mode is needed for baud rates higher than (CPU Hz / 16)
+  if (baud > F_CPU / 16UL) {
+    use_u2x = 1;
+  } else {
+    error = labs((long) (F_CPU / 16 / (ubrr + 1UL)) - (long) baud);
+    error_u2x = labs((long) (F_CPU / 8 / (ubrr_u2x + 1UL)) - (long) baud);
+    use_u2x = error_u2x < error;
+  }
+
+  hwusart_init_ubrr(port, use_u2x ? ubrr_u2x : ubrr, use_u2x, 
+                    data_size, parity, stopbits);
+}
+
+void hwusart_rx_isr(THWUsartPort *port)
+{
+  uint8_t write_pos = port->rx_write_pos;
+
+  if ( (port->receive_complete) &&   
+       (port->rx_read_pos == write_pos) ) 
+  {
+    port->overrun=1;
+    port->rx_read_pos = (write_pos + 1) & port->rx_mask;
+  }
+  port->rx_buffer[write_pos] = *port->udr;
+  port->rx_write_pos = (write_pos + 1) & port->rx_mask;
+  port->receive_complete=1;
+}
+
+/* Return True if all data were sent to UDR */
+static uint8_t hwusart_tx_end(THWUsartPort *port)
+{
+  if (port->tx_data_text) {
+    char ch;
+    if (port->tx_data_pgm) {
+      ch = pgm_read_byte(port->tx_data);
+    } else {
+      ch = * port->tx_data;
+    }
+    return (ch == '\0');
+  }
+  return (port->tx_length == 0);
+}
+
+void hwusart_udre_isr(THWUsartPort *port)
+{
+  char ch;
+
+  if (! hwusart_tx_end(port)) {
+    if (port->tx_data_pgm) {
+      ch = pgm_read_byte(port->tx_data++);
+    } else {
+      ch = *(port->tx_data++);
+    }
+    *port->udr = ch;
+    port->tx_length--;
+  } else {
+    *port->ucsrb &= ~_BV(UDRIE0);  /* No data - Disable TX interrupt */
+  }
+}
+
+uint16_t hwusart_available(THWUsartPort *port)
+{
+  uint8_t len;
+
+  if (port->receive_complete) {
+    len = (port->rx_write_pos - port->rx_read_pos) & port->rx_mask;
+    if (len == 0) {
+      return port->rx_mask + 1;
+    }
+    return len;
+  }
+  return 0;
+}
+
+uint8_t hwusart_getchar(THWUsartPort *port)
+{
+  char ch = '\0';
+
+  if (hwusart_available(port)) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      ch = port->rx_buffer[port->rx_read_pos];
+      port->rx_read_pos = (port->rx_read_pos + 1) & port->rx_mask;
+      port->overrun=0; //Clear overrun flag
+
+      if (port->rx_read_pos == port->rx_write_pos) {
+        port->receive_complete=0;
+      }
+    }
+  }
+  return ch;
+}
+
+uint8_t hwusart_startswith(THWUsartPort *port, const char * text, uint8_t pgm)
+{
+  uint8_t buffer_index, write_pos;
+  uint8_t buffer_end = 0;
+  char ch;
+
+  if (hwusart_available(port)) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      buffer_index = port->rx_read_pos;
+      write_pos = port->rx_write_pos;
+    }
+    ch = pgm ? pgm_read_byte(text) : *text;
+    while ( (ch != '\0') && (!buffer_end) )  
+    {
+      if ( ch != port->rx_buffer[buffer_index] ) {
+        return 0; // False
+      }
+      buffer_index = (buffer_index + 1) & port->rx_mask;
+      if (buffer_index == write_pos) {
+        buffer_end = 1;
+      }
+      text++;
+      ch = pgm ? pgm_read_byte(text) : *text;
+    }
+    return (ch == '\0');
+  }
+  return 0;
+}
+
+uint8_t hwusart_readstr(THWUsartPort *port, const char * text, uint8_t pgm)
+{
+  if (hwusart_startswith(port, text, pgm)) {
+    hwusart_rx_consume(port, pgm ? strlen_P(text) : strlen(text));
+    return 1;
+  }
+  return 0;
+}
+
+uint8_t hwusart_readn(THWUsartPort *port, char * destination, uint8_t num)
+{
+  uint16_t buf_len;
+  uint8_t result = 0;
+  
+  buf_len = hwusart_available(port);
+  while ((buf_len > 0) && (num > 0)) {
+    *(destination++) = hwusart_getchar(port);
+    buf_len--;
+    num--;
+    result++;
+  }
+  while (num > 0) {
+    *(destination++) = '\0';
+    num--;
+  }
+  return result;
+}
+
+uint16_t hwusart_rx_peek(THWUsartPort *port, const char ** data)
+{
+  uint16_t len;
+  uint8_t read_pos;
+
+  len = hwusart_available(port);
+  read_pos = port->rx_read_pos;
+  *data = &port->rx_buffer[read_pos];
+  if (len > port->rx_mask + 1 - read_pos) {
+    len = port->rx_mask + 1 - read_pos;  // Data continue at the beginning of the buffer
+  }
+  return len;
+}
+
+void hwusart_rx_consume(THWUsartPort *port, uint16_t num)
+{
+  uint16_t len;
+
+  len = hwusart_available(port);
+  if (num > len) {
+    num = len;
+  }
+  if (num > 0) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      port->rx_read_pos = (port->rx_read_pos + num) & port->rx_mask;
+      port->overrun=0; //Clear overrun flag
+
+      if (port->rx_read_pos == port->rx_write_pos) {
+        port->receive_complete=0;
+      }
+    }
+  }
+}
+
+void hwusart_clear(THWUsartPort *port)
+{
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    port->rx_read_pos=0;
+    port->rx_write_pos=0;
+    port->overrun=0;
+    port->receive_complete=0;
+  }
+}
+
+uint8_t hwusart_tx_empty(THWUsartPort *port)
+{
+  if (hwusart_tx_end(port)) {
+    return *port->ucsra & _BV(UDRE0);
+  }
+  return 0;
+}
+
+void hwusart_tx_wait(THWUsartPort *port)
+{
+  while (! hwusart_tx_empty(port)) {
+    #ifdef USART_IDLE_SLEEP
+      hwusart_idle(port->ucsrb, _BV(UDRIE0));
+    #endif
+  }
+}
+
+void hwusart_putchar(THWUsartPort *port, char ch)
+{
+  port->tx_length = 0;
+  port->tx_data_text = 0;
+  *port->udr = ch; 
+}
+
+void hwusart_send(THWUsartPort *port, const char* data, uint8_t len, uint8_t flags)
+{
+  if ( (len > 0) || (flags & _HWUSART_TEXT) ) {
+    port->tx_data = data;
+    port->tx_length = len;
+    port->tx_data_pgm = (flags & _HWUSART_PGM) != 0;
+    port->tx_data_text = (flags & _HWUSART_TEXT) != 0;
+    *port->ucsrb |= _BV(UDRIE0);
+  }
+}
+
+void hwusart_bsend(THWUsartPort *port, const char* data, uint8_t len, uint8_t flags)
+{
+  hwusart_send(port, data, len, flags);
+  hwusart_tx_wait(port);
+}
+
+#undef _URSEL
+#endif // USART_SHARED
@@ -19,25 +19,191 @@
  * In the global.h you can define following optional settings: 
  *   USART_ENABLE         - USART/0 enable 
  *   USART_RX_BUFFER      - USART/0 size of circular RX buffer 
+ *   USART_TX_BUFFER      - USART/0 size of circular TX buffer 
  *   USART_TX_ISR_DISABLE - USART/0 disable TX interrupt routine. 
+ *   USART_RX_DELIMITER   - USART/0 line delimiter, enable line mode
+ *   USART_BAUD           - USART/0 baud rate for usart_init_static
+ *   USART_PACKET         - USART/0 packet mode (COBS framing)
+ *   USART_PACKET_CRC     - USART/0 CRC-16 of packets
+ *   USART_RX_HOOK        - USART/0 function called from RX ISR
+ *   USART_RTS            - USART/0 RTS output pin for flow control
+ *   USART_CTS            - USART/0 CTS input pin for flow control
+ *   USART_XONXOFF        - USART/0 XON/XOFF flow control
+ *   USART_FLOW_HIGH      - USART/0 RX level to stop the sender
+ *   USART_FLOW_LOW       - USART/0 RX level to resume the sender
+ *   USART_STATS          - USART/0 error and throughput counters
+ *   USART_STDIO          - USART/0 stdio streams usart_stdout, usart_stdin
+ *   USART_MSPIM          - USART/0 Master SPI mode, value is XCK pin
+ *   USART_AUTOBAUD       - USART/0 RX pin for autobaud (sync character 0x55)
+ *   USART_MPCM           - USART/0 multiprocessor mode (9-bit address frames)
+ *   USART_RS485_NO_ECHO  - USART/0 disable RX during RS-485 transmission
+ *   USART_RS485_DE       - USART/0 RS-485 driver enable pin (e.g. ioPD2)
  *
  *   USART1_ENABLE     - USART1 enable
  *   USART1_RX_BUFFER  - USART1 size of circular RX buffer
+ *   USART1_TX_BUFFER  - USART1 size of circular TX buffer
  *   USART1_TX_ISR_DISABLE - USART1 disable TX interrupt routine. 
+ *   USART1_RX_DELIMITER  - USART1 line delimiter, enable line mode
+ *   USART1_BAUD          - USART1 baud rate for usart1_init_static
+ *   USART1_PACKET        - USART1 packet mode (COBS framing)
+ *   USART1_PACKET_CRC    - USART1 CRC-16 of packets
+ *   USART1_RX_HOOK       - USART1 function called from RX ISR
+ *   USART1_RTS           - USART1 RTS output pin for flow control
+ *   USART1_CTS           - USART1 CTS input pin for flow control
+ *   USART1_XONXOFF       - USART1 XON/XOFF flow control
+ *   USART1_FLOW_HIGH     - USART1 RX level to stop the sender
+ *   USART1_FLOW_LOW      - USART1 RX level to resume the sender
+ *   USART1_STATS         - USART1 error and throughput counters
+ *   USART1_STDIO         - USART1 stdio streams usart1_stdout, usart1_stdin
+ *   USART1_MSPIM         - USART1 Master SPI mode, value is XCK pin
+ *   USART1_AUTOBAUD      - USART1 RX pin for autobaud (sync character 0x55)
+ *   USART1_MPCM          - USART1 multiprocessor mode (9-bit address frames)
+ *   USART1_RS485_NO_ECHO - USART1 disable RX during RS-485 transmission
+ *   USART1_RS485_DE      - USART1 RS-485 driver enable pin (e.g. ioPD2)
  *
  *   USART2_ENABLE     - USART2 enable
  *   USART2_RX_BUFFER  - USART2 size of circular RX buffer
+ *   USART2_TX_BUFFER  - USART2 size of circular TX buffer
  *   USART2_TX_ISR_DISABLE - USART2 disable TX interrupt routine. 
+ *   USART2_RX_DELIMITER  - USART2 line delimiter, enable line mode
+ *   USART2_BAUD          - USART2 baud rate for usart2_init_static
+ *   USART2_PACKET        - USART2 packet mode (COBS framing)
+ *   USART2_PACKET_CRC    - USART2 CRC-16 of packets
+ *   USART2_RX_HOOK       - USART2 function called from RX ISR
+ *   USART2_RTS           - USART2 RTS output pin for flow control
+ *   USART2_CTS           - USART2 CTS input pin for flow control
+ *   USART2_XONXOFF       - USART2 XON/XOFF flow control
+ *   USART2_FLOW_HIGH     - USART2 RX level to stop the sender
+ *   USART2_FLOW_LOW      - USART2 RX level to resume the sender
+ *   USART2_STATS         - USART2 error and throughput counters
+ *   USART2_STDIO         - USART2 stdio streams usart2_stdout, usart2_stdin
+ *   USART2_MSPIM         - USART2 Master SPI mode, value is XCK pin
+ *   USART2_AUTOBAUD      - USART2 RX pin for autobaud (sync character 0x55)
+ *   USART2_MPCM          - USART2 multiprocessor mode (9-bit address frames)
+ *   USART2_RS485_NO_ECHO - USART2 disable RX during RS-485 transmission
+ *   USART2_RS485_DE      - USART2 RS-485 driver enable pin (e.g. ioPD2)
  *    
  *   USART3_ENABLE     - USART3 enable
  *   USART3_RX_BUFFER  - USART3 size of circular RX buffer
+ *   USART3_TX_BUFFER  - USART3 size of circular TX buffer
  *   USART3_TX_ISR_DISABLE - USART3 disable TX interrupt routine. 
+ *   USART3_RX_DELIMITER  - USART3 line delimiter, enable line mode
+ *   USART3_BAUD          - USART3 baud rate for usart3_init_static
+ *   USART3_PACKET        - USART3 packet mode (COBS framing)
+ *   USART3_PACKET_CRC    - USART3 CRC-16 of packets
+ *   USART3_RX_HOOK       - USART3 function called from RX ISR
+ *   USART3_RTS           - USART3 RTS output pin for flow control
+ *   USART3_CTS           - USART3 CTS input pin for flow control
+ *   USART3_XONXOFF       - USART3 XON/XOFF flow control
+ *   USART3_FLOW_HIGH     - USART3 RX level to stop the sender
+ *   USART3_FLOW_LOW      - USART3 RX level to resume the sender
+ *   USART3_STATS         - USART3 error and throughput counters
+ *   USART3_STDIO         - USART3 stdio streams usart3_stdout, usart3_stdin
+ *   USART3_MSPIM         - USART3 Master SPI mode, value is XCK pin
+ *   USART3_AUTOBAUD      - USART3 RX pin for autobaud (sync character 0x55)
+ *   USART3_MPCM          - USART3 multiprocessor mode (9-bit address frames)
+ *   USART3_RS485_NO_ECHO - USART3 disable RX during RS-485 transmission
+ *   USART3_RS485_DE      - USART3 RS-485 driver enable pin (e.g. ioPD2)
  *
  * If you will not enable any USART. The USART/0 is enabled 
  * by default. Default size of RX buffer is 8. If you want to use 
  * for example USART0 and USART1 you must manualy enable both USARTs i.e. 
  * you must define USART_ENABLE and USART1_ENABLE.
  *
+ * Default size of TX buffer is 0. The send/print functions store only
+ * the pointer to the transmitted data and the next call overwrites it.
+ * Function send_segments sends the message composed of several segments 
+ * (RAM or program memory, binary or text) without copying them.
+ * When the TX buffer is set, send/print/putchar copy data into the circular
+ * buffer and several messages can be queued. The functions wait only when
+ * the buffer is full, use tx_free to test free space before the call.
+ *
+ * When RX_DELIMITER is defined (e.g. '\n'), the RX interrupt routine counts
+ * received delimiters. Functions lines_available and readline return
+ * whole lines without repeated scanning of the receive buffer.
+ *
+ * When BAUD is defined, function init_static can be used instead of init.
+ * UBRR value and U2X mode are computed during compilation. The compilation 
+ * fails if the baud rate error is higher than USART_BAUD_TOL percent 
+ * (default 2 %).
+ *
+ * When PACKET is defined, the USART sends and receives packets framed 
+ * by COBS (Consistent Overhead Byte Stuffing), each packet is terminated
+ * by zero byte. The packet is encoded by the UDRE interrupt routine during 
+ * transmission (packet_send) and decoded by the RX interrupt routine into
+ * the RX buffer. Only complete packets are visible to packet_read, damaged
+ * packets are dropped and the receiver is synchronized again by the next 
+ * zero byte. With PACKET_CRC, CRC-16 (CCITT) is appended to every packet 
+ * and checked during reception. The packet mode requires RX buffer and 
+ * cannot be used with TX buffer, TX_ISR_DISABLE and RX_DELIMITER.
+ * Number of received packets waiting in the RX buffer is limited by 
+ * USART_PACKET_QUEUE (default 4).
+ *
+ * RX_HOOK is name of function `uint8_t hook(uint8_t ch)`, which is called
+ * from the RX interrupt routine for every received character (e.g. for
+ * protocol timing). The character is stored into the RX buffer only when 
+ * the hook returns non-zero. The hook can be used without RX buffer.
+ *
+ * When RS485_DE is defined, the pin (avrio pin number) is set HIGH when
+ * the transmission starts and set LOW by the TX complete interrupt 
+ * routine after the last stop bit. With RS485_NO_ECHO, the receiver is 
+ * disabled while the driver is enabled.
+ *
+ * Flow control: when the RX buffer contains FLOW_HIGH characters 
+ * (default 3/4 of the buffer), the RX interrupt routine sets RTS pin HIGH
+ * and/or sends XOFF. When the buffer is read down to FLOW_LOW characters
+ * (default 1/4), RTS is set LOW and/or XON is sent. The transmission is 
+ * paused while CTS pin is HIGH or after XOFF is received. The paused 
+ * transmission is resumed by XON or by function cts_poll, which is called
+ * when the TX functions wait (call it from the main loop or from a pin 
+ * change interrupt too). RTS and CTS are avrio pin numbers.
+ *
+ * When STATS is defined, interrupt routines count received and sent 
+ * characters, errors (FE, DOR, UPE flags, RX buffer overruns) and peak
+ * usage of the RX buffer. Function stats reads the counters atomically.
+ *
+ * When STDIO is defined, usartn_stdout and usartn_stdin are avr-libc 
+ * stdio streams (e.g. stdout = &usart_stdout). Output is written into
+ * the TX buffer and waits only when the buffer is full (without TX buffer
+ * every character waits for the transmission). Input waits for the next
+ * received character.
+ *
+ * When AUTOBAUD is defined (avrio pin of RXD), function autobaud measures 
+ * the sync character 0x55 sent by the other side and initializes the USART
+ * with the measured baud rate. Timer1 is used during the measurement, its
+ * interrupts must be disabled.
+ *
+ * When MPCM is defined, the USART works in multiprocessor communication
+ * mode (9 data bits, init must be called with data_size 9). Frames with 
+ * the 9th bit set are addresses. Function mpcm_listen sets own address 
+ * and enables MPCM filter - the hardware ignores data frames, so there is
+ * no interrupt until an address frame is received. When the address is 
+ * own or USART_MPCM_BROADCAST, following data frames are stored into 
+ * the RX buffer until the next address frame. Address frames are not 
+ * stored, function mpcm_selected returns how the node was addressed. 
+ * Function send_address sends an address frame (blocking). After init
+ * only USART_MPCM_BROADCAST selects the node until mpcm_listen is called.
+ *
+ * When MSPIM is defined, the USART works in Master SPI mode (hwusart_mspim.inc)
+ * and only the MSPIM functions are available: init, transfer (interrupt 
+ * driven full-duplex block transfer), transfer_done, btransfer and 
+ * transfer_byte. The value of MSPIM is avrio pin of XCK, chip select 
+ * is controlled by the application.
+ *
+ * When USART_IDLE_SLEEP is defined, functions which wait for the 
+ * transmission (tx_wait, blocking functions, putchar/send with full 
+ * TX buffer) put the CPU into SLEEP_MODE_IDLE until the next interrupt.
+ * The CPU sleeps only while the UDRE interrupt is enabled, so the wait
+ * is always finished by an interrupt.
+ *
+ * When USART_SHARED is defined, all USARTs use one implementation in 
+ * hwserial.c. Each USART is described by THWUsartPort structure (register
+ * addresses, RX buffer, state) and the interrupt routines only select the
+ * structure, the usartn_ functions are inline calls of the shared code.
+ * It is limited to the basic configuration: RX buffer up to 256 bytes, 
+ * TX without buffer and BAUD, other options cannot be used. The flash 
+ * saving was not measured, compare avr-size of both builds.
+ *
  */
 
 #ifndef HWSERIAL_H_INCLUDED
@@ -45,11 +211,30 @@
 
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <util/crc16.h>
 #include <stdlib.h>
+#include <string.h>
 #include <avr/pgmspace.h>
 #include "preprocessor.h"
 #include "global.h"
 
+#if defined(USART_RS485_DE) || defined(USART1_RS485_DE) || \
+    defined(USART2_RS485_DE) || defined(USART3_RS485_DE) || \
+    defined(USART_RTS) || defined(USART1_RTS) ||             \
+    defined(USART2_RTS) || defined(USART3_RTS) ||             \
+    defined(USART_CTS) || defined(USART1_CTS) ||             \
+    defined(USART2_CTS) || defined(USART3_CTS) ||             \
+    defined(USART_MSPIM) || defined(USART1_MSPIM) ||         \
+    defined(USART2_MSPIM) || defined(USART3_MSPIM) ||         \
+    defined(USART_AUTOBAUD) || defined(USART1_AUTOBAUD) ||   \
+    defined(USART2_AUTOBAUD) || defined(USART3_AUTOBAUD)
+  #include "avrio.h"
+#endif
+#ifdef USART_IDLE_SLEEP
+  #include <avr/sleep.h>
+#endif
+
 #define UARTS_PARITY_NONE 0
 #define UARTS_PARITY_EVEN 2
 #define UARTS_PARITY_ODD 3
@@ -57,9 +242,209 @@
 #define UARTS_STOPBIT_TWO 2
 
 /* Default length of RX buffer.
- * The value must be power of 2: i.e.: 0, 2, 4, 8, 16, 32, 64, 128, 256 */
+ * The value must be power of 2: i.e.: 0, 2, 4, 8, 16, 32, 64, 128, 256, 
+ * 512, 1024, 2048, 4096. Buffers bigger than 256 bytes use 16-bit positions. */
 #define USART_DEFAULT_RX_BUFFER 8
 
+/* Default length of TX buffer.
+ * The value must be power of 2: i.e.: 0, 2, 4, 8, 16, 32, 64, 128, 256 */
+#define USART_DEFAULT_TX_BUFFER 0
+
+/* Maximal number of received packets in the RX buffer (power of 2) */
+#ifndef USART_PACKET_QUEUE
+  #define USART_PACKET_QUEUE 4
+#endif
+
+/* Segment of the message for function send_segments */
+typedef struct {
+  const char *data;
+  uint8_t length;           // number of bytes, not used by text segments
+  uint8_t flags;            // USART_SEGMENT_RAM or USART_SEGMENT_PGM, 
+                            // optionally | USART_SEGMENT_TEXT
+} TUsartSegment;
+
+#define USART_SEGMENT_RAM  0
+#define USART_SEGMENT_PGM  1
+#define USART_SEGMENT_TEXT 2    // null terminated text
+
+/* Statistics counters of one USART (USARTn_STATS) */
+typedef struct {
+  uint32_t rx_bytes;        // received characters
+  uint32_t tx_bytes;        // transmitted characters
+  uint16_t hw_overruns;     // data overrun in the USART (DOR flag)
+  uint16_t sw_overruns;     // lost data - RX buffer full, dropped packets
+  uint16_t frame_errors;    // FE flag
+  uint16_t parity_errors;   // UPE flag
+  uint16_t rx_peak;         // maximal number of characters in RX buffer
+} TUsartStats;
+
+/* Function which sends one character, used by number formatting */
+typedef void (*TUsartPutchar)(char ch);
+
+/* Send unsigned value with at most digits (1..10) decimal digits, leading 
+   zeros are suppressed. When decimals > 0, decimal point is inserted before 
+   the last decimals digits, "0." and zeros are added when decimals is not 
+   less than digits. Digits are computed by subtraction of powers of ten, 
+   no division is used. */
+extern void hwusart_format_dec(TUsartPutchar put, uint32_t value, 
+                               uint8_t digits, uint8_t decimals);
+/* Send signed value, see hwusart_format_dec */
+extern void hwusart_format_int(TUsartPutchar put, int32_t value, uint8_t decimals);
+/* Send exactly digits (1..8) hexadecimal digits of value */
+extern void hwusart_format_hex(TUsartPutchar put, uint32_t value, uint8_t digits);
+
+/* Compute the baud rate from timestamps of five falling edges of the sync
+   character 0x55 (Timer1 ticks with prescaler 8). Rates close to standard
+   rates are rounded to them. Return 0 if the edges do not match 0x55. */
+extern uint32_t hwusart_autobaud_rate(const uint16_t *edges);
+
+#ifdef USART_IDLE_SLEEP
+/* Sleep in SLEEP_MODE_IDLE until the next interrupt when the UDRE interrupt
+   is enabled (udrie bit in ucsrb), i.e. when some interrupt must come. */
+extern void hwusart_idle(volatile uint8_t *ucsrb, uint8_t udrie);
+#endif
+
+/* The following macro functions are helper functions for the Protothread
+   library from http://dunkels.com/adam/pt/ . Several protothreads can share
+   the USART without blocking functions.
+
+   Input parameters:
+     pt   - A pointer to the protothread control structure.
+     port - Function prefix of the USART: usart, usart1, usart2, usart3.
+
+   Attention! - without TX buffer data/text must be global NOT local variable,
+   use PT_USART_WAIT_TX before it is changed.
+ */
+#define PT_USART_WAIT_RX(pt, port, n) \
+    PT_WAIT_UNTIL((pt), CAT(port, _available)() >= (n))
+#define PT_USART_WAIT_LINE(pt, port) \
+    PT_WAIT_UNTIL((pt), CAT(port, _lines_available)() > 0)
+#define PT_USART_WAIT_TX(pt, port) \
+    PT_WAIT_UNTIL((pt), CAT(port, _tx_empty)())
+#define PT_USART_SEND(pt, port, data, len)                   \
+    do {                                                     \
+      PT_WAIT_UNTIL((pt), CAT(port, _tx_ready)(len));        \
+      CAT(port, _send)((data), (len));                       \
+    } while (0)
+#define PT_USART_PRINT(pt, port, text)                       \
+    do {                                                     \
+      PT_WAIT_UNTIL((pt), CAT(port, _tx_ready)(strlen(text))); \
+      CAT(port, _print)(text);                               \
+    } while (0)
+#define PT_USART_PRINT_P(pt, port, text)                     \
+    do {                                                     \
+      PT_WAIT_UNTIL((pt), CAT(port, _tx_ready)(strlen_P(text))); \
+      CAT(port, _print_P)(text);                             \
+    } while (0)
+
+#ifdef USART_SHARED
+/* Registers and state of one USART in the shared mode (USART_SHARED) */
+typedef struct {
+  volatile uint8_t *ucsra;
+  volatile uint8_t *ucsrb;
+  volatile uint8_t *ucsrc;
+  volatile uint8_t *ubrrl;
+  volatile uint8_t *ubrrh;
+  volatile uint8_t *udr;
+  char *rx_buffer;
+  uint8_t rx_mask;            // size of rx_buffer - 1
+  /* Fields changed by interrupt routines are volatile, the shared 
+     functions cannot be optimized for one USART */
+  volatile uint8_t rx_read_pos;
+  volatile uint8_t rx_write_pos;
+  volatile uint8_t receive_complete : 1;
+  volatile uint8_t overrun : 1;
+  const char * volatile tx_data;
+  volatile uint8_t tx_length;
+  uint8_t tx_data_pgm  : 1;
+  uint8_t tx_data_text : 1;
+} THWUsartPort;
+
+/* Flags of hwusart_send */
+#define _HWUSART_PGM  1       // data are in program memory
+#define _HWUSART_TEXT 2       // null terminated text
+
+/* Shared implementation of the USART functions (hwserial.c) */
+extern void hwusart_init(THWUsartPort *port, unsigned long baud, 
+                         uint8_t data_size, uint8_t parity, uint8_t stopbits);
+extern void hwusart_init_ubrr(THWUsartPort *port, uint16_t ubrr, uint8_t use_u2x,
+                         uint8_t data_size, uint8_t parity, uint8_t stopbits);
+extern void hwusart_rx_isr(THWUsartPort *port);
+extern void hwusart_udre_isr(THWUsartPort *port);
+extern uint16_t hwusart_available(THWUsartPort *port);
+extern uint8_t hwusart_getchar(THWUsartPort *port);
+extern uint8_t hwusart_startswith(THWUsartPort *port, const char * text, uint8_t pgm);
+extern uint8_t hwusart_readstr(THWUsartPort *port, const char * text, uint8_t pgm);
+extern uint8_t hwusart_readn(THWUsartPort *port, char * destination, uint8_t num);
+extern uint16_t hwusart_rx_peek(THWUsartPort *port, const char ** data);
+extern void hwusart_rx_consume(THWUsartPort *port, uint16_t num);
+extern void hwusart_clear(THWUsartPort *port);
+extern uint8_t hwusart_tx_empty(THWUsartPort *port);
+extern void hwusart_tx_wait(THWUsartPort *port);
+extern void hwusart_putchar(THWUsartPort *port, char ch);
+extern void hwusart_send(THWUsartPort *port, const char* data, uint8_t len, uint8_t flags);
+extern void hwusart_bsend(THWUsartPort *port, const char* data, uint8_t len, uint8_t flags);
+
+  #define _HWUSART_INC "hwusart_shared.inc"
+#else
+  #define _HWUSART_INC "hwusart_single.inc"
+#endif
+
+/* Protothread wrapper of the MSPIM block transfer, see PT_USART_SEND */
+#define PT_USART_TRANSFER(pt, port, tx, rx, len)                 \
+    do {                                                         \
+      PT_WAIT_UNTIL((pt), CAT(port, _transfer)((tx), (rx), (len))); \
+      PT_WAIT_UNTIL((pt), CAT(port, _transfer_done)());          \
+    } while (0)
+
+/* Software flow control characters */
+#define USART_XON  0x11
+#define USART_XOFF 0x13
+
+/* Address of all nodes in USARTn_MPCM mode */
+#ifndef USART_MPCM_BROADCAST
+  #define USART_MPCM_BROADCAST 0xFF
+#endif
+
+/* Result of mpcm_selected - selection by the last address frame */
+#define USART_MPCM_NONE 0     // data frames are ignored
+#define USART_MPCM_OWN  1     // own address
+#define USART_MPCM_ALL  2     // broadcast address
+
+/* States of the packet transmission */
+#define _USART_PACKET_IDLE  0   // no packet is transmitted
+#define _USART_PACKET_BLOCK 1   // COBS blocks are transmitted
+#define _USART_PACKET_LAST  2   // the last block is transmitted, delimiter follows
+
+/* End of the searched COBS block (tx_next_end) */
+#define _USART_PACKET_END_NONE 0   // not found yet
+#define _USART_PACKET_END_ZERO 1   // zero byte or 254 non-zero bytes
+#define _USART_PACKET_END_LAST 2   // end of the packet
+
+/* Maximal number of bytes searched for the block end in one UDRE interrupt */
+#define _USART_PACKET_SCAN 16
+
+/* Maximal baud rate error (in percent) for USARTn_BAUD */
+#ifndef USART_BAUD_TOL
+  #define USART_BAUD_TOL 2
+#endif
+
+/* Compile time computation of baud rate settings. The macros can be used
+ * in preprocessor conditions.
+ *   USART_UBRR(baud, u2x)       - UBRR value rounded to the nearest
+ *   USART_BAUD_ERROR(baud, u2x) - baud rate error in 0.1 %
+ */
+#define USART_UBRR(baud, u2x) \
+  ( ((F_CPU) + 4ULL * (2 - (u2x)) * (baud)) / (8ULL * (2 - (u2x)) * (baud)) - 1 )
+
+#define _USART_REAL_BAUD1000(baud, u2x) \
+  ( 1000ULL * (F_CPU) / (8ULL * (2 - (u2x)) * (USART_UBRR(baud, u2x) + 1)) )
+
+#define USART_BAUD_ERROR(baud, u2x)                                   \
+  ( ( (_USART_REAL_BAUD1000(baud, u2x) > 1000ULL * (baud)) ?          \
+      (_USART_REAL_BAUD1000(baud, u2x) - 1000ULL * (baud)) :          \
+      (1000ULL * (baud) - _USART_REAL_BAUD1000(baud, u2x)) ) / (baud) )
+
 /* We default enable USART0 if user did not enabled other */
 #if !defined(USART_ENABLE) && !defined(USART1_ENABLE) && \
     !defined(USART2_ENABLE) && !defined(USART3_ENABLE) 
@@ -70,10 +455,82 @@
   #error Do not use USART0_RX_BUFFER. Define USART_RX_BUFFER for USART0.
 #endif
 
+#ifdef USART0_TX_BUFFER
+  #error Do not use USART0_TX_BUFFER. Define USART_TX_BUFFER for USART0.
+#endif
+
+#ifdef USART0_RX_DELIMITER
+  #error Do not use USART0_RX_DELIMITER. Define USART_RX_DELIMITER for USART0.
+#endif
+
+#ifdef USART0_BAUD
+  #error Do not use USART0_BAUD. Define USART_BAUD for USART0.
+#endif
+
+#ifdef USART0_PACKET
+  #error Do not use USART0_PACKET. Define USART_PACKET for USART0.
+#endif
+
+#ifdef USART0_PACKET_CRC
+  #error Do not use USART0_PACKET_CRC. Define USART_PACKET_CRC for USART0.
+#endif
+
 #ifdef USART0_TX_ISR_DISABLE
   #error Do not use USART0_TX_ISR_DISABLE. Define USART_TX_ISR_DISABLE for USART0.
 #endif
 
+#ifdef USART0_RX_HOOK
+  #error Do not use USART0_RX_HOOK. Define USART_RX_HOOK for USART0.
+#endif
+
+#ifdef USART0_RTS
+  #error Do not use USART0_RTS. Define USART_RTS for USART0.
+#endif
+
+#ifdef USART0_CTS
+  #error Do not use USART0_CTS. Define USART_CTS for USART0.
+#endif
+
+#ifdef USART0_XONXOFF
+  #error Do not use USART0_XONXOFF. Define USART_XONXOFF for USART0.
+#endif
+
+#ifdef USART0_FLOW_HIGH
+  #error Do not use USART0_FLOW_HIGH. Define USART_FLOW_HIGH for USART0.
+#endif
+
+#ifdef USART0_FLOW_LOW
+  #error Do not use USART0_FLOW_LOW. Define USART_FLOW_LOW for USART0.
+#endif
+
+#ifdef USART0_STATS
+  #error Do not use USART0_STATS. Define USART_STATS for USART0.
+#endif
+
+#ifdef USART0_STDIO
+  #error Do not use USART0_STDIO. Define USART_STDIO for USART0.
+#endif
+
+#ifdef USART0_MSPIM
+  #error Do not use USART0_MSPIM. Define USART_MSPIM for USART0.
+#endif
+
+#ifdef USART0_AUTOBAUD
+  #error Do not use USART0_AUTOBAUD. Define USART_AUTOBAUD for USART0.
+#endif
+
+#ifdef USART0_MPCM
+  #error Do not use USART0_MPCM. Define USART_MPCM for USART0.
+#endif
+
+#ifdef USART0_RS485_NO_ECHO
+  #error Do not use USART0_RS485_NO_ECHO. Define USART_RS485_NO_ECHO for USART0.
+#endif
+
+#ifdef USART0_RS485_DE
+  #error Do not use USART0_RS485_DE. Define USART_RS485_DE for USART0.
+#endif
+
 #if defined(USART_RX_BUFFER) && !defined(USART_ENABLE)
   #error USART_RX_BUFFER is set but USART/0 is disabled (USART_ENABLE not defined). 
 #endif
@@ -87,6 +544,19 @@
   #error USART_RX_BUFFER is set but USART3 is disabled (USART3_ENABLE not defined). 
 #endif
 
+#if defined(USART_TX_BUFFER) && !defined(USART_ENABLE)
+  #error USART_TX_BUFFER is set but USART/0 is disabled (USART_ENABLE not defined). 
+#endif
+#if defined(USART1_TX_BUFFER) && !defined(USART1_ENABLE)
+  #error USART1_TX_BUFFER is set but USART1 is disabled (USART1_ENABLE not defined). 
+#endif
+#if defined(USART2_TX_BUFFER) && !defined(USART2_ENABLE)
+  #error USART2_TX_BUFFER is set but USART2 is disabled (USART2_ENABLE not defined). 
+#endif
+#if defined(USART3_TX_BUFFER) && !defined(USART3_ENABLE)
+  #error USART3_TX_BUFFER is set but USART3 is disabled (USART3_ENABLE not defined). 
+#endif
+
 #ifndef USART_RX_BUFFER 
   #define USART_RX_BUFFER USART_DEFAULT_RX_BUFFER
 #endif
@@ -102,6 +572,21 @@
   #define USART3_RX_BUFFER USART_DEFAULT_RX_BUFFER
 #endif
 
+#ifndef USART_TX_BUFFER 
+  #define USART_TX_BUFFER USART_DEFAULT_TX_BUFFER
+#endif
+#define USART0_TX_BUFFER USART_TX_BUFFER
+
+#ifndef USART1_TX_BUFFER 
+  #define USART1_TX_BUFFER USART_DEFAULT_TX_BUFFER
+#endif
+#ifndef USART2_TX_BUFFER 
+  #define USART2_TX_BUFFER USART_DEFAULT_TX_BUFFER
+#endif
+#ifndef USART3_TX_BUFFER 
+  #define USART3_TX_BUFFER USART_DEFAULT_TX_BUFFER
+#endif
+
 #ifdef USART_ENABLE
   #ifdef UDR
     #define USART_NUMBER
@@ -114,60 +599,349 @@
   #ifdef USART_TX_ISR_DISABLE   
     #define _USART_TX_ISR_DISABLE
   #endif
+  #ifdef USART_RX_DELIMITER
+    #define _USART_RX_DELIMITER USART_RX_DELIMITER
+  #endif
+  #ifdef USART_BAUD
+    #define _USART_BAUD USART_BAUD
+  #endif
+  #ifdef USART_PACKET
+    #define _USART_PACKET
+  #endif
+  #ifdef USART_PACKET_CRC
+    #define _USART_PACKET_CRC
+  #endif
+  #ifdef USART_RX_HOOK
+    #define _USART_RX_HOOK USART_RX_HOOK
+  #endif
+  #ifdef USART_RS485_DE
+    #define _USART_RS485_DE USART_RS485_DE
+  #endif
+  #ifdef USART_RS485_NO_ECHO
+    #define _USART_RS485_NO_ECHO
+  #endif
+  #ifdef USART_RTS
+    #define _USART_RTS USART_RTS
+  #endif
+  #ifdef USART_CTS
+    #define _USART_CTS USART_CTS
+  #endif
+  #ifdef USART_XONXOFF
+    #define _USART_XONXOFF
+  #endif
+  #ifdef USART_FLOW_HIGH
+    #define _USART_FLOW_HIGH USART_FLOW_HIGH
+  #endif
+  #ifdef USART_FLOW_LOW
+    #define _USART_FLOW_LOW USART_FLOW_LOW
+  #endif
+  #ifdef USART_STATS
+    #define _USART_STATS
+  #endif
+  #ifdef USART_STDIO
+    #define _USART_STDIO
+  #endif
+  #ifdef USART_MSPIM
+    #define _USART_MSPIM USART_MSPIM
+  #endif
+  #ifdef USART_AUTOBAUD
+    #define _USART_AUTOBAUD USART_AUTOBAUD
+  #endif
+  #ifdef USART_MPCM
+    #define _USART_MPCM
+  #endif
 
   #ifdef USART_NUMBER
-    #include "hwusart_single.inc"
+    #ifdef _USART_MSPIM
+      #include "hwusart_mspim.inc"
+    #else
+      #include _HWUSART_INC
+    #endif
   #endif
   
 #endif //USART0_ENABLE
 #undef USART_NUMBER
 #undef _USART_TX_ISR_DISABLE
+#undef _USART_RX_DELIMITER
+#undef _USART_BAUD
+#undef _USART_PACKET
+#undef _USART_PACKET_CRC
+#undef _USART_RX_HOOK
+#undef _USART_RTS
+#undef _USART_CTS
+#undef _USART_XONXOFF
+#undef _USART_FLOW_HIGH
+#undef _USART_FLOW_LOW
+#undef _USART_STATS
+#undef _USART_STDIO
+#undef _USART_MSPIM
+#undef _USART_AUTOBAUD
+#undef _USART_MPCM
+#undef _USART_RS485_NO_ECHO
+#undef _USART_RS485_DE
 
 #ifdef USART1_ENABLE
   #ifdef USART1_TX_ISR_DISABLE   
     #define _USART_TX_ISR_DISABLE
   #endif
+  #ifdef USART1_RX_DELIMITER
+    #define _USART_RX_DELIMITER USART1_RX_DELIMITER
+  #endif
+  #ifdef USART1_BAUD
+    #define _USART_BAUD USART1_BAUD
+  #endif
+  #ifdef USART1_PACKET
+    #define _USART_PACKET
+  #endif
+  #ifdef USART1_PACKET_CRC
+    #define _USART_PACKET_CRC
+  #endif
+  #ifdef USART1_RX_HOOK
+    #define _USART_RX_HOOK USART1_RX_HOOK
+  #endif
+  #ifdef USART1_RS485_DE
+    #define _USART_RS485_DE USART1_RS485_DE
+  #endif
+  #ifdef USART1_RS485_NO_ECHO
+    #define _USART_RS485_NO_ECHO
+  #endif
+  #ifdef USART1_RTS
+    #define _USART_RTS USART1_RTS
+  #endif
+  #ifdef USART1_CTS
+    #define _USART_CTS USART1_CTS
+  #endif
+  #ifdef USART1_XONXOFF
+    #define _USART_XONXOFF
+  #endif
+  #ifdef USART1_FLOW_HIGH
+    #define _USART_FLOW_HIGH USART1_FLOW_HIGH
+  #endif
+  #ifdef USART1_FLOW_LOW
+    #define _USART_FLOW_LOW USART1_FLOW_LOW
+  #endif
+  #ifdef USART1_STATS
+    #define _USART_STATS
+  #endif
+  #ifdef USART1_STDIO
+    #define _USART_STDIO
+  #endif
+  #ifdef USART1_MSPIM
+    #define _USART_MSPIM USART1_MSPIM
+  #endif
+  #ifdef USART1_AUTOBAUD
+    #define _USART_AUTOBAUD USART1_AUTOBAUD
+  #endif
+  #ifdef USART1_MPCM
+    #define _USART_MPCM
+  #endif
 
   #ifdef UDR1
     #define USART_NUMBER 1
-    #include "hwusart_single.inc"
+    #ifdef _USART_MSPIM
+      #include "hwusart_mspim.inc"
+    #else
+      #include _HWUSART_INC
+    #endif
   #else
     #error Sorry your device does not have HW USART1.
   #endif
 #endif
 #undef USART_NUMBER
 #undef _USART_TX_ISR_DISABLE
+#undef _USART_RX_DELIMITER
+#undef _USART_BAUD
+#undef _USART_PACKET
+#undef _USART_PACKET_CRC
+#undef _USART_RX_HOOK
+#undef _USART_RTS
+#undef _USART_CTS
+#undef _USART_XONXOFF
+#undef _USART_FLOW_HIGH
+#undef _USART_FLOW_LOW
+#undef _USART_STATS
+#undef _USART_STDIO
+#undef _USART_MSPIM
+#undef _USART_AUTOBAUD
+#undef _USART_MPCM
+#undef _USART_RS485_NO_ECHO
+#undef _USART_RS485_DE
 
 #ifdef USART2_ENABLE
   #ifdef USART2_TX_ISR_DISABLE   
     #define _USART_TX_ISR_DISABLE
   #endif
+  #ifdef USART2_RX_DELIMITER
+    #define _USART_RX_DELIMITER USART2_RX_DELIMITER
+  #endif
+  #ifdef USART2_BAUD
+    #define _USART_BAUD USART2_BAUD
+  #endif
+  #ifdef USART2_PACKET
+    #define _USART_PACKET
+  #endif
+  #ifdef USART2_PACKET_CRC
+    #define _USART_PACKET_CRC
+  #endif
+  #ifdef USART2_RX_HOOK
+    #define _USART_RX_HOOK USART2_RX_HOOK
+  #endif
+  #ifdef USART2_RS485_DE
+    #define _USART_RS485_DE USART2_RS485_DE
+  #endif
+  #ifdef USART2_RS485_NO_ECHO
+    #define _USART_RS485_NO_ECHO
+  #endif
+  #ifdef USART2_RTS
+    #define _USART_RTS USART2_RTS
+  #endif
+  #ifdef USART2_CTS
+    #define _USART_CTS USART2_CTS
+  #endif
+  #ifdef USART2_XONXOFF
+    #define _USART_XONXOFF
+  #endif
+  #ifdef USART2_FLOW_HIGH
+    #define _USART_FLOW_HIGH USART2_FLOW_HIGH
+  #endif
+  #ifdef USART2_FLOW_LOW
+    #define _USART_FLOW_LOW USART2_FLOW_LOW
+  #endif
+  #ifdef USART2_STATS
+    #define _USART_STATS
+  #endif
+  #ifdef USART2_STDIO
+    #define _USART_STDIO
+  #endif
+  #ifdef USART2_MSPIM
+    #define _USART_MSPIM USART2_MSPIM
+  #endif
+  #ifdef USART2_AUTOBAUD
+    #define _USART_AUTOBAUD USART2_AUTOBAUD
+  #endif
+  #ifdef USART2_MPCM
+    #define _USART_MPCM
+  #endif
   #ifdef UDR2
     #define USART_NUMBER 2
-    #include "hwusart_single.inc"
+    #ifdef _USART_MSPIM
+      #include "hwusart_mspim.inc"
+    #else
+      #include _HWUSART_INC
+    #endif
   #else
     #error Sorry your device does not support HW USART2.
   #endif
 #endif
 #undef USART_NUMBER
 #undef _USART_TX_ISR_DISABLE
+#undef _USART_RX_DELIMITER
+#undef _USART_BAUD
+#undef _USART_PACKET
+#undef _USART_PACKET_CRC
+#undef _USART_RX_HOOK
+#undef _USART_RTS
+#undef _USART_CTS
+#undef _USART_XONXOFF
+#undef _USART_FLOW_HIGH
+#undef _USART_FLOW_LOW
+#undef _USART_STATS
+#undef _USART_STDIO
+#undef _USART_MSPIM
+#undef _USART_AUTOBAUD
+#undef _USART_MPCM
+#undef _USART_RS485_NO_ECHO
+#undef _USART_RS485_DE
 
 #ifdef USART3_ENABLE
   #ifdef USART3_TX_ISR_DISABLE   
     #define _USART_TX_ISR_DISABLE
   #endif
+  #ifdef USART3_RX_DELIMITER
+    #define _USART_RX_DELIMITER USART3_RX_DELIMITER
+  #endif
+  #ifdef USART3_BAUD
+    #define _USART_BAUD USART3_BAUD
+  #endif
+  #ifdef USART3_PACKET
+    #define _USART_PACKET
+  #endif
+  #ifdef USART3_PACKET_CRC
+    #define _USART_PACKET_CRC
+  #endif
+  #ifdef USART3_RX_HOOK
+    #define _USART_RX_HOOK USART3_RX_HOOK
+  #endif
+  #ifdef USART3_RS485_DE
+    #define _USART_RS485_DE USART3_RS485_DE
+  #endif
+  #ifdef USART3_RS485_NO_ECHO
+    #define _USART_RS485_NO_ECHO
+  #endif
+  #ifdef USART3_RTS
+    #define _USART_RTS USART3_RTS
+  #endif
+  #ifdef USART3_CTS
+    #define _USART_CTS USART3_CTS
+  #endif
+  #ifdef USART3_XONXOFF
+    #define _USART_XONXOFF
+  #endif
+  #ifdef USART3_FLOW_HIGH
+    #define _USART_FLOW_HIGH USART3_FLOW_HIGH
+  #endif
+  #ifdef USART3_FLOW_LOW
+    #define _USART_FLOW_LOW USART3_FLOW_LOW
+  #endif
+  #ifdef USART3_STATS
+    #define _USART_STATS
+  #endif
+  #ifdef USART3_STDIO
+    #define _USART_STDIO
+  #endif
+  #ifdef USART3_MSPIM
+    #define _USART_MSPIM USART3_MSPIM
+  #endif
+  #ifdef USART3_AUTOBAUD
+    #define _USART_AUTOBAUD USART3_AUTOBAUD
+  #endif
+  #ifdef USART3_MPCM
+    #define _USART_MPCM
+  #endif
   #ifdef UDR3
     #define USART_NUMBER 3
-    #include "hwusart_single.inc"
+    #ifdef _USART_MSPIM
+      #include "hwusart_mspim.inc"
+    #else
+      #include _HWUSART_INC
+    #endif
   #else
     #error Sorry your device does not support HW USART3.
   #endif
 #endif
 #undef USART_NUMBER
 #undef _USART_TX_ISR_DISABLE
+#undef _USART_RX_DELIMITER
+#undef _USART_BAUD
+#undef _USART_PACKET
+#undef _USART_PACKET_CRC
+#undef _USART_RX_HOOK
+#undef _USART_RTS
+#undef _USART_CTS
+#undef _USART_XONXOFF
+#undef _USART_FLOW_HIGH
+#undef _USART_FLOW_LOW
+#undef _USART_STATS
+#undef _USART_STDIO
+#undef _USART_MSPIM
+#undef _USART_AUTOBAUD
+#undef _USART_MPCM
+#undef _USART_RS485_NO_ECHO
+#undef _USART_RS485_DE
 
 
 #undef USART_DEFAULT_RX_BUFFER
+#undef USART_DEFAULT_TX_BUFFER
 
 
 #endif //SERIAL_H_INCLUDED
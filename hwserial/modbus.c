@@ -0,0 +1,236 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <util/atomic.h>
+#include <util/crc16.h>
+#include "modbus.h"
+
+/* Receiver states */
+#define MODBUS_RECEIVE  0   // frame is received
+#define MODBUS_IGNORE   1   // too long frame, wait for the gap
+#define MODBUS_REPLY    2   // response is transmitted
+
+static struct {
+  uint8_t frame[MODBUS_BUFFER];
+  volatile uint16_t length;     // received bytes in frame
+  volatile uint16_t crc;        // CRC of received bytes, zero for valid frame
+  volatile uint16_t last_time;  // time0 of the last received byte
+  volatile uint8_t state;
+  uint16_t gap;                 // 3.5 character time in time0 ticks
+  uint8_t address;
+  const TModbusMap *map;
+} modbus;
+
+void modbus_init(uint8_t address, unsigned long baud, const TModbusMap *map)
+{
+  unsigned long gap_us;
+
+  /* 3.5 characters of 11 bits, fixed 1750 us above 19200 Bd */
+  if (baud > 19200) {
+    gap_us = 1750;
+  } else {
+    gap_us = (35UL * 11 * 100000UL) / baud;
+  }
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    modbus.address = address;
+    modbus.map = map;
+    /* Round up and add one tick for the unknown phase of the timer */
+    modbus.gap = (gap_us * (F_CPU / 1000000UL) + (CLK_DIV) * 256UL - 1) / 
+                 ((CLK_DIV) * 256UL) + 1;
+    modbus.length = 0;
+    modbus.state = MODBUS_RECEIVE;
+  }
+}
+
+uint8_t modbus_rx_hook(uint8_t ch)
+{
+  uint16_t now = time0;
+  uint16_t length = modbus.length;
+
+  if (modbus.state == MODBUS_REPLY) {
+    return 0;   // Echo of the response (RS-485)
+  }
+  if ((uint16_t) (now - modbus.last_time) >= modbus.gap) {
+    /* Silent interval - start of the new frame */
+    length = 0;
+    modbus.state = MODBUS_RECEIVE;
+  }
+  modbus.last_time = now;
+
+  if (length == 0) {
+    modbus.crc = 0xFFFF;
+  }
+  if (length < MODBUS_BUFFER) {
+    modbus.frame[length++] = ch;
+    modbus.crc = _crc16_update(modbus.crc, ch);
+  } else {
+    modbus.state = MODBUS_IGNORE;
+  }
+  modbus.length = length;
+  return 0;
+}
+
+static inline uint16_t modbus_word(const uint8_t *data)
+{
+  return (data[0] << 8) | data[1];
+}
+
+static inline void modbus_set_word(uint8_t *data, uint16_t value)
+{
+  data[0] = value >> 8;
+  data[1] = value & 0xFF;
+}
+
+/* Process request in the frame and build the response in place.
+ * Return length of the response without CRC. 
+ */
+static uint8_t modbus_process(uint8_t length)
+{
+  uint8_t *frame = modbus.frame;
+  const TModbusMap *map = modbus.map;
+  uint16_t start, count, i, value;
+  uint8_t exception = 0;
+
+  if ( (frame[1] != 3) && (frame[1] != 4) && (frame[1] != 6) && 
+       (frame[1] != 16) ) {
+    exception = MODBUS_ILLEGAL_FUNCTION;
+  } else if (length < 6) {
+    exception = MODBUS_ILLEGAL_VALUE;
+  } else {
+    start = modbus_word(&frame[2]);
+    count = modbus_word(&frame[4]);
+
+    switch (frame[1]) {
+      case 3:
+      case 4:
+        if ( (count == 0) || (count > 125) || 
+             ((uint16_t) (2 * count + 5) > MODBUS_BUFFER) ) {
+          exception = MODBUS_ILLEGAL_VALUE;
+        } else if ( (frame[1] == 3) ?
+                    ((uint32_t) start + count > map->holding_count) :
+                    ((uint32_t) start + count > map->input_count) ) {
+          exception = MODBUS_ILLEGAL_ADDRESS;
+        } else {
+          frame[2] = 2 * count;
+          for (i = 0; i < count; i++) {
+            if (frame[1] == 3) {
+              value = map->holding[start + i];
+            } else if (map->input_pgm) {
+              value = pgm_read_word(&map->input[start + i]);
+            } else {
+              value = map->input[start + i];
+            }
+            modbus_set_word(&frame[3 + 2 * i], value);
+          }
+          return 3 + 2 * count;
+        }
+        break;
+
+      case 6:
+        if (start >= map->holding_count) {
+          exception = MODBUS_ILLEGAL_ADDRESS;
+        } else {
+          map->holding[start] = count;    // count is the register value
+          if (map->written) {
+            map->written(start, 1);
+          }
+          return 6;   // Echo of the request
+        }
+        break;
+
+      case 16:
+        if ( (count == 0) || (count > 123) || (length < 7) ||
+             (frame[6] != 2 * count) || (length < 7 + 2 * count) ) {
+          exception = MODBUS_ILLEGAL_VALUE;
+        } else if ((uint32_t) start + count > map->holding_count) {
+          exception = MODBUS_ILLEGAL_ADDRESS;
+        } else {
+          for (i = 0; i < count; i++) {
+            map->holding[start + i] = modbus_word(&frame[7 + 2 * i]);
+          }
+          if (map->written) {
+            map->written(start, count);
+          }
+          return 6;   // Address, function, start and count
+        }
+        break;
+    }
+  }
+  frame[1] |= 0x80;
+  frame[2] = exception;
+  return 3;
+}
+
+uint8_t modbus_poll(void)
+{
+  uint16_t length, last_time, crc;
+  uint8_t state, function;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    length = modbus.length;
+    last_time = modbus.last_time;
+    crc = modbus.crc;
+    state = modbus.state;
+  }
+
+  if (state == MODBUS_REPLY) {
+    if (_modbus_usart_function(tx_empty)()) {
+      modbus.length = 0;
+      modbus.state = MODBUS_RECEIVE;
+    }
+    return 0;
+  }
+  if ( (length == 0) || ((uint16_t) (time0 - last_time) < modbus.gap) ) {
+    return 0;   // Nothing received or the frame is not finished
+  }
+
+  /* Whole frame received. The hook ignores bytes until the response 
+   * is sent, unless the next frame has already started. */
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if (modbus.length != length) {
+      length = 0;
+    } else {
+      modbus.state = MODBUS_REPLY;
+    }
+  }
+  if (length == 0) {
+    return 0;
+  }
+
+  function = modbus.frame[1];
+  if ( (state == MODBUS_IGNORE) || (length < 4) || (crc != 0) ||
+       ((modbus.frame[0] != modbus.address) && (modbus.frame[0] != 0)) ) {
+    modbus.length = 0;
+    modbus.state = MODBUS_RECEIVE;
+    return 0;
+  }
+
+  length = modbus_process(length - 2);
+  if (modbus.frame[0] == 0) {
+    /* Broadcast - no response */
+    modbus.length = 0;
+    modbus.state = MODBUS_RECEIVE;
+    return function;
+  }
+  crc = 0xFFFF;
+  for (uint8_t i = 0; i < length; i++) {
+    crc = _crc16_update(crc, modbus.frame[i]);
+  }
+  modbus.frame[length++] = crc & 0xFF;
+  modbus.frame[length++] = crc >> 8;
+  _modbus_usart_function(send)((const char *) modbus.frame, length);
+  return function;
+}
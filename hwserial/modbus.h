@@ -0,0 +1,107 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Modbus RTU slave on top of hwserial.
+ *
+ * Received bytes are processed by the RX hook modbus_rx_hook, which 
+ * stores them into the frame buffer and updates CRC. The end of the frame 
+ * is detected by a silent interval of 3.5 characters measured by the 
+ * counter time0 (avrtime.h). The frame is processed by modbus_poll 
+ * called from the main loop, the response is built in the same buffer 
+ * and sent by usart_send.
+ *
+ * Supported function codes:
+ *    3 - Read Holding Registers
+ *    4 - Read Input Registers
+ *    6 - Write Single Register
+ *   16 - Write Multiple Registers
+ *
+ * Configuration in global.h:
+ *   MODBUS_USART  - number of used USART (empty or 0 for USART/0, 1, 2, 3)
+ *   MODBUS_BUFFER - size of the frame buffer (default 256 - max. Modbus frame)
+ *   USARTn_RX_HOOK modbus_rx_hook   - required for the MODBUS_USART
+ *   USARTn_RX_BUFFER 0              - recommended, the buffer is not used
+ *   CLK_DIV                         - timer prescaler for avrtime.h
+ *
+ * Example:
+ *    static uint16_t holding[10];
+ *    static const uint16_t inputs[2] PROGMEM = {0x1234, 0x5678};
+ *    static const TModbusMap map = {holding, 10, inputs, 2, 1, NULL};
+ *
+ *    usart_init(19200, 8, UARTS_PARITY_EVEN, 1);
+ *    modbus_init(1, 19200, &map);
+ *    while (1) {
+ *      modbus_poll();
+ *    }
+ */
+
+#ifndef MODBUS_H_INCLUDED
+#define MODBUS_H_INCLUDED
+
+#include "hwserial.h"
+#include "avrtime.h"
+
+#ifndef MODBUS_USART
+  #define MODBUS_USART
+#endif
+
+#ifndef MODBUS_BUFFER
+  #define MODBUS_BUFFER 256
+#endif
+
+#if (MODBUS_BUFFER < 8) || (MODBUS_BUFFER > 256)
+  #error MODBUS_BUFFER must be 8 .. 256
+#endif
+
+/* Function of the hwserial library for the USART MODBUS_USART */
+#if IS_EMPTY_DEF(MODBUS_USART)
+  #define _modbus_usart_function(name) CAT(usart, _ ## name)
+#elif MODBUS_USART==0
+  #define _modbus_usart_function(name) CAT(usart, _ ## name)
+#else
+  #define _modbus_usart_function(name) CAT3(usart, MODBUS_USART, _ ## name)
+#endif
+
+/* Exception codes */
+#define MODBUS_ILLEGAL_FUNCTION     1
+#define MODBUS_ILLEGAL_ADDRESS      2
+#define MODBUS_ILLEGAL_VALUE        3
+
+typedef struct {
+  uint16_t *holding;          // Holding registers in RAM (function 3, 6, 16)
+  uint16_t holding_count;
+  const uint16_t *input;      // Input registers (function 4)
+  uint16_t input_count;
+  uint8_t input_pgm;          // True if input registers are in the program memory
+  /* Called after holding registers are written by the master, can be NULL */
+  void (*written)(uint16_t start, uint16_t count);
+} TModbusMap;
+
+/* Initialize slave with the address (1 - 247). The baud rate is used 
+ * for computation of the inter-frame gap. The USART must be initialized 
+ * separately.
+ */
+extern void modbus_init(uint8_t address, unsigned long baud, const TModbusMap *map);
+
+/* Process received frame and send the response. Return function code of 
+ * the processed request or 0 when no valid request was received.
+ */
+extern uint8_t modbus_poll(void);
+
+/* RX hook for USARTn_RX_HOOK */
+extern uint8_t modbus_rx_hook(uint8_t ch);
+
+#endif // MODBUS_H_INCLUDED
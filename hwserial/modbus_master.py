@@ -0,0 +1,119 @@
+# 
+# Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+# 
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# Modbus RTU master for testing of modbus.h slaves. Requests are sent 
+# with the inter-frame gap of 3.5 characters and response latency is 
+# measured (from the end of the request to the first byte of the response).
+#
+# Usage: 
+#   python modbus_master.py port baudrate slave read  start count [repeat]
+#   python modbus_master.py port baudrate slave input start count [repeat]
+#   python modbus_master.py port baudrate slave write start value [value ...]
+#
+# The pyserial module is required. Parity is even (Modbus default).
+
+from __future__ import print_function
+import binascii
+import struct
+import sys
+import time
+
+import serial
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in bytearray(data):
+        crc ^= byte
+        for i in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+def frame(data):
+    return data + struct.pack("<H", crc16(data))
+
+
+class Master(object):
+    def __init__(self, port, baudrate):
+        self.port = serial.Serial(port, baudrate, parity=serial.PARITY_EVEN, timeout=0)
+        self.char_time = 11.0 / baudrate
+        self.gap = 0.00175 if baudrate > 19200 else 3.5 * self.char_time
+
+    def request(self, data, response_length, timeout=1.0):
+        """Send request and return (response, latency in seconds)"""
+        time.sleep(self.gap)
+        self.port.reset_input_buffer()
+        self.port.write(frame(data))
+        self.port.flush()   # Wait until the request is sent
+        sent = time.time()
+        response = bytearray()
+        first = None
+        last = sent
+        while time.time() - sent < timeout:
+            chunk = self.port.read(256)
+            now = time.time()
+            if chunk:
+                if first is None:
+                    first = now
+                last = now
+                response += chunk
+            elif response and (now - last > self.gap or len(response) >= response_length):
+                break
+        if not response:
+            raise IOError("No response")
+        if crc16(bytes(response)) != 0:
+            raise IOError("Wrong CRC of the response: %s" % (binascii.hexlify(bytes(response)),))
+        if response[1] & 0x80:
+            raise IOError("Exception %d" % (response[2],))
+        return bytes(response[:-2]), first - sent
+
+
+def main():
+    if len(sys.argv) < 7:
+        sys.exit("Usage: python modbus_master.py port baudrate slave read|input|write start count|value ...")
+    port, baudrate, slave, command = sys.argv[1], int(sys.argv[2]), int(sys.argv[3]), sys.argv[4]
+    start = int(sys.argv[5], 0)
+    master = Master(port, baudrate)
+
+    if command in ("read", "input"):
+        count = int(sys.argv[6], 0)
+        repeat = int(sys.argv[7]) if len(sys.argv) > 7 else 1
+        function = 3 if command == "read" else 4
+        latencies = []
+        for i in range(repeat):
+            response, latency = master.request(struct.pack(">BBHH", slave, function, start, count), 5 + 2 * count)
+            latencies.append(latency)
+        values = struct.unpack(">%dH" % (count,), response[3:3 + 2 * count])
+        print(" ".join("%d" % (value,) for value in values))
+    elif command == "write":
+        values = [int(value, 0) for value in sys.argv[6:]]
+        if len(values) == 1:
+            data = struct.pack(">BBHH", slave, 6, start, values[0])
+        else:
+            data = struct.pack(">BBHHB%dH" % (len(values),), slave, 16, start, len(values), 2 * len(values), *values)
+        response, latency = master.request(data, 8)
+        latencies = [latency]
+    else:
+        sys.exit("Unknown command %s" % (command,))
+
+    print("latency: min %.2f ms, avg %.2f ms, max %.2f ms (%d requests)" % (
+          1000 * min(latencies), 1000 * sum(latencies) / len(latencies), 
+          1000 * max(latencies), len(latencies)))
+
+
+if __name__ == "__main__":
+    main()
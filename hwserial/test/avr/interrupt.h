@@ -0,0 +1,31 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MOCK_AVR_INTERRUPT_H_INCLUDED
+#define MOCK_AVR_INTERRUPT_H_INCLUDED
+
+#include <avr/io.h>
+
+/* Interrupt routines are ordinary functions called by mock.c */
+#define ISR(vector, ...) void vector(void); void vector(void)
+
+/* Number of cli calls (including ATOMIC_BLOCK) */
+extern uint32_t mock_cli_count;
+
+#define sei() (SREG |= _BV(SREG_I))
+#define cli() (mock_cli_count++, SREG &= ~_BV(SREG_I))
+
+#endif // MOCK_AVR_INTERRUPT_H_INCLUDED
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Host mock of the AVR registers used by hwserial (USART0 of ATmega328P,
+ * Timer1, SMCR). USART registers are accessed through functions of mock.c,
+ * every access moves the simulated USART and calls enabled interrupt 
+ * routines, see mock.h.
+ */
+
+#ifndef MOCK_AVR_IO_H_INCLUDED
+#define MOCK_AVR_IO_H_INCLUDED
+
+#include <stdint.h>
+
+#define _BV(bit) (1 << (bit))
+#define bit_is_set(sfr, bit) ((sfr) & _BV(bit))
+#define bit_is_clear(sfr, bit) (!((sfr) & _BV(bit)))
+
+extern volatile uint8_t *mock_reg(uint8_t reg);
+extern volatile uint16_t *mock_udr(void);
+
+#define MOCK_UCSR0A 0
+#define MOCK_UCSR0B 1
+#define MOCK_UCSR0C 2
+#define MOCK_UBRR0L 3
+#define MOCK_UBRR0H 4
+#define MOCK_REGS   5
+
+#define UCSR0A (*mock_reg(MOCK_UCSR0A))
+#define UCSR0B (*mock_reg(MOCK_UCSR0B))
+#define UCSR0C (*mock_reg(MOCK_UCSR0C))
+#define UBRR0L (*mock_reg(MOCK_UBRR0L))
+#define UBRR0H (*mock_reg(MOCK_UBRR0H))
+/* Every access of UDR0 gets a new 16-bit cell, mock.c then finds out 
+   whether the cell was written (value other than MOCK_UDR_EMPTY) */
+#define UDR0   (*mock_udr())
+
+/* UCSR0A */
+#define RXC0  7
+#define TXC0  6
+#define UDRE0 5
+#define FE0   4
+#define DOR0  3
+#define UPE0  2
+#define U2X0  1
+#define MPCM0 0
+
+/* UCSR0B */
+#define RXCIE0 7
+#define TXCIE0 6
+#define UDRIE0 5
+#define RXEN0  4
+#define TXEN0  3
+#define UCSZ02 2
+#define RXB80  1
+#define TXB80  0
+
+/* UCSR0C */
+#define UMSEL01 7
+#define UMSEL00 6
+#define UPM01   5
+#define UPM00   4
+#define USBS0   3
+#define UCSZ01  2
+#define UCSZ00  1
+#define UCPOL0  0
+
+#define USART0_RX_vect   mock_usart_rx_isr
+#define USART0_UDRE_vect mock_usart_udre_isr
+#define USART0_TX_vect   mock_usart_tx_isr
+#define USART_RX_vect    USART0_RX_vect
+
+extern volatile uint8_t SREG;
+#define SREG_I 7
+
+extern volatile uint8_t SMCR;
+#define SE  0
+#define SM0 1
+#define SM1 2
+#define SM2 3
+
+extern volatile uint8_t TCCR1A, TCCR1B, TIFR1, TIMSK1;
+extern volatile uint16_t TCNT1;
+#define CS11 1
+#define TOV1 0
+
+#ifdef MOCK_GPIO
+/* GPIO registers at their data space addresses - ports B, C, D of 
+ * ATmega328P or ports A .. L of ATmega2560 with MOCK_ATMEGA2560 (PINH 
+ * and higher are outside the I/O space, avrio.h uses IO_REG16). The 
+ * register table of avrio.c stores the addresses as 16-bit integers, so 
+ * the registers cannot be host variables. Tests move the addresses into 
+ * mock_gpio before the access.
+ */
+#define MOCK_GPIO_SIZE 0x110
+extern volatile uint8_t mock_gpio[MOCK_GPIO_SIZE];
+
+#define _MOCK_REG(addr) (*(volatile uint8_t *) (addr))
+#ifdef MOCK_ATMEGA2560
+  #define PINA  _MOCK_REG(0x20)
+  #define DDRA  _MOCK_REG(0x21)
+  #define PORTA _MOCK_REG(0x22)
+#endif
+#define PINB  _MOCK_REG(0x23)
+#define DDRB  _MOCK_REG(0x24)
+#define PORTB _MOCK_REG(0x25)
+#define PINC  _MOCK_REG(0x26)
+#define DDRC  _MOCK_REG(0x27)
+#define PORTC _MOCK_REG(0x28)
+#define PIND  _MOCK_REG(0x29)
+#define DDRD  _MOCK_REG(0x2A)
+#define PORTD _MOCK_REG(0x2B)
+#ifdef MOCK_ATMEGA2560
+  #define PINE  _MOCK_REG(0x2C)
+  #define DDRE  _MOCK_REG(0x2D)
+  #define PORTE _MOCK_REG(0x2E)
+  #define PINF  _MOCK_REG(0x2F)
+  #define DDRF  _MOCK_REG(0x30)
+  #define PORTF _MOCK_REG(0x31)
+  #define PING  _MOCK_REG(0x32)
+  #define DDRG  _MOCK_REG(0x33)
+  #define PORTG _MOCK_REG(0x34)
+  #define PINH  _MOCK_REG(0x100)
+  #define DDRH  _MOCK_REG(0x101)
+  #define PORTH _MOCK_REG(0x102)
+  #define PINJ  _MOCK_REG(0x103)
+  #define DDRJ  _MOCK_REG(0x104)
+  #define PORTJ _MOCK_REG(0x105)
+  #define PINK  _MOCK_REG(0x106)
+  #define DDRK  _MOCK_REG(0x107)
+  #define PORTK _MOCK_REG(0x108)
+  #define PINL  _MOCK_REG(0x109)
+  #define DDRL  _MOCK_REG(0x10A)
+  #define PORTL _MOCK_REG(0x10B)
+#endif
+#endif // MOCK_GPIO
+
+#endif // MOCK_AVR_IO_H_INCLUDED
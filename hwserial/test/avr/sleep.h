@@ -0,0 +1,39 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MOCK_AVR_SLEEP_H_INCLUDED
+#define MOCK_AVR_SLEEP_H_INCLUDED
+
+#include <avr/io.h>
+
+#define SLEEP_MODE_IDLE       0
+#define SLEEP_MODE_ADC        _BV(SM0)
+#define SLEEP_MODE_PWR_DOWN   _BV(SM1)
+#define SLEEP_MODE_PWR_SAVE   (_BV(SM0) | _BV(SM1))
+
+#define _SLEEP_CONTROL_REG SMCR
+#define _SLEEP_MODE_MASK   (_BV(SM0) | _BV(SM1) | _BV(SM2))
+
+#define set_sleep_mode(mode) \
+    (SMCR = (SMCR & ~_SLEEP_MODE_MASK) | (mode))
+#define sleep_enable()  (SMCR |= _BV(SE))
+#define sleep_disable() (SMCR &= ~_BV(SE))
+
+/* The simulated USART runs until some interrupt routine is called */
+extern void mock_sleep(void);
+#define sleep_cpu() mock_sleep()
+
+#endif // MOCK_AVR_SLEEP_H_INCLUDED
@@ -0,0 +1,262 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MOCK_GPIO
+#include <stdlib.h>
+#include <string.h>
+#include <avr/sleep.h>
+#include "mock.h"
+
+/* Interrupt routines defined by the tested configuration */
+extern void mock_usart_rx_isr(void) __attribute__((weak));
+extern void mock_usart_udre_isr(void) __attribute__((weak));
+extern void mock_usart_tx_isr(void) __attribute__((weak));
+
+#define ISR_NONE 0
+#define ISR_RX   1
+#define ISR_UDRE 2
+#define ISR_TXC  3
+
+/* Simulation stops when sleep or flush does not finish in this time */
+#define MOCK_TIMEOUT 10000000UL
+
+TMock mock;
+int mock_failures;
+uint32_t mock_cli_count;
+
+volatile uint8_t SREG;
+volatile uint8_t SMCR;
+volatile uint8_t TCCR1A, TCCR1B, TIFR1, TIMSK1;
+volatile uint16_t TCNT1;
+volatile uint16_t time0;          // avrtime.h
+volatile uint8_t mock_gpio[MOCK_GPIO_SIZE];
+
+static volatile uint8_t regs[MOCK_REGS];
+static volatile uint16_t udr_cell = MOCK_UDR_EMPTY;
+static uint8_t udr_cell_read;       // the cell was given to RX routine
+static uint16_t udr_tx = MOCK_UDR_EMPTY;
+static uint8_t udr_rx;
+static uint16_t tx_shift;           // ticks until the character is sent
+static uint8_t tx_char;
+static uint16_t rx_wait;            // ticks until the next character
+static uint8_t flag_rxc, flag_txc, flag_dor;
+static uint8_t in_isr = ISR_NONE;
+static uint16_t time0_wait;         // ticks until time0 is incremented
+
+void mock_reset(void)
+{
+  memset(&mock, 0, sizeof(mock));
+  memset((void *) regs, 0, sizeof(regs));
+  mock.char_ticks = 10;
+  udr_cell = MOCK_UDR_EMPTY;
+  udr_tx = MOCK_UDR_EMPTY;
+  tx_shift = 0;
+  rx_wait = 0;
+  flag_rxc = flag_txc = flag_dor = 0;
+  in_isr = ISR_NONE;
+  time0 = 0;
+  time0_wait = 0;
+  SREG = _BV(SREG_I);
+  SMCR = 0;
+}
+
+void mock_rx_push(const void *data, uint16_t len)
+{
+  if (mock.rx_pos == mock.rx_len) {
+    mock.rx_pos = mock.rx_len = 0;    // all characters were received
+  }
+  if (mock.rx_len + len > MOCK_BUFFER) {
+    printf("mock: RX data too long\n");
+    exit(2);
+  }
+  memcpy(mock.rx + mock.rx_len, data, len);
+  mock.rx_len += len;
+}
+
+/* Process the previous UDR0 cell - it was written by the program */
+static void mock_udr_write(void)
+{
+  if ( (!udr_cell_read) && (udr_cell != MOCK_UDR_EMPTY) ) {
+    if (udr_tx != MOCK_UDR_EMPTY) {
+      mock.udr_overwrites++;
+    }
+    udr_tx = udr_cell & 0xFF;
+  }
+  udr_cell = MOCK_UDR_EMPTY;
+  udr_cell_read = 0;
+}
+
+static void mock_call(uint8_t isr, void (*routine)(void))
+{
+  uint8_t sreg = SREG;
+
+  SREG &= ~_BV(SREG_I);
+  in_isr = isr;
+  routine();
+  mock_udr_write();
+  in_isr = ISR_NONE;
+  SREG = sreg;
+}
+
+/* Move the simulation by one tick. Return True if an interrupt routine 
+ * was called.
+ */
+static uint8_t mock_tick(void)
+{
+  uint8_t ucsrb = regs[MOCK_UCSR0B];
+
+  mock_udr_write();
+  mock.ticks++;
+
+  /* Timer overflow of avrtime.h */
+  if ( (mock.time0_ticks > 0) && (++time0_wait >= mock.time0_ticks) ) {
+    time0_wait = 0;
+    time0++;
+  }
+
+  /* Transmitter */
+  if (tx_shift > 0) {
+    if (--tx_shift == 0) {
+      if (mock.tx_len < MOCK_BUFFER) {
+        mock.tx[mock.tx_len++] = tx_char;
+      }
+      flag_txc = (udr_tx == MOCK_UDR_EMPTY);
+    }
+  }
+  if ( (tx_shift == 0) && (udr_tx != MOCK_UDR_EMPTY) ) {
+    tx_char = udr_tx;
+    udr_tx = MOCK_UDR_EMPTY;
+    tx_shift = mock.char_ticks;
+    flag_txc = 0;
+  }
+
+  /* Receiver */
+  if ( (ucsrb & _BV(RXEN0)) && (mock.rx_pos < mock.rx_len) ) {
+    if (rx_wait == 0) {
+      rx_wait = mock.char_ticks;
+    }
+    if (--rx_wait == 0) {
+      if (flag_rxc) {
+        flag_dor = 1;
+        mock.rx_overruns++;
+      } else {
+        udr_rx = mock.rx[mock.rx_pos];
+        flag_rxc = 1;
+      }
+      mock.rx_pos++;
+    }
+  }
+
+  regs[MOCK_UCSR0A] = (regs[MOCK_UCSR0A] & (_BV(U2X0) | _BV(MPCM0))) |
+                      (flag_rxc ? _BV(RXC0) : 0) |
+                      (flag_txc ? _BV(TXC0) : 0) |
+                      ((udr_tx == MOCK_UDR_EMPTY) ? _BV(UDRE0) : 0) |
+                      (flag_dor ? _BV(DOR0) : 0);
+
+  /* Interrupts */
+  if ( (in_isr != ISR_NONE) || bit_is_clear(SREG, SREG_I) ) {
+    return 0;
+  }
+  if ( flag_rxc && (ucsrb & _BV(RXCIE0)) && mock_usart_rx_isr ) {
+    mock.rx_isr++;
+    mock_call(ISR_RX, mock_usart_rx_isr);
+    return 1;
+  }
+  if ( (udr_tx == MOCK_UDR_EMPTY) && (ucsrb & _BV(UDRIE0)) && mock_usart_udre_isr ) {
+    mock.udre_isr++;
+    mock_call(ISR_UDRE, mock_usart_udre_isr);
+    if (udr_tx == MOCK_UDR_EMPTY) {
+      mock.udre_idle++;
+    }
+    if (mock.udre_hook) {
+      mock.udre_hook();
+    }
+    return 1;
+  }
+  if ( flag_txc && (ucsrb & _BV(TXCIE0)) && mock_usart_tx_isr ) {
+    flag_txc = 0;     // cleared by the interrupt
+    mock.txc_isr++;
+    mock_call(ISR_TXC, mock_usart_tx_isr);
+    return 1;
+  }
+  return 0;
+}
+
+volatile uint8_t *mock_reg(uint8_t reg)
+{
+  mock_tick();
+  return &regs[reg];
+}
+
+volatile uint16_t *mock_udr(void)
+{
+  mock_tick();
+  if (in_isr == ISR_RX) {
+    /* Reading of UDR0 clears RXC and DOR */
+    udr_cell = udr_rx;
+    udr_cell_read = 1;
+    flag_rxc = 0;
+    flag_dor = 0;
+  }
+  return &udr_cell;
+}
+
+void mock_sleep(void)
+{
+  uint32_t i;
+
+  if ( !(SMCR & _BV(SE)) ) {
+    printf("mock: sleep_cpu without sleep_enable\n");
+    exit(2);
+  }
+  if ( (SMCR & _SLEEP_MODE_MASK) != SLEEP_MODE_IDLE ) {
+    printf("mock: USART does not run in the sleep mode %02X\n", SMCR);
+    exit(2);
+  }
+  mock.sleeps++;
+  for (i = 0; i < MOCK_TIMEOUT; i++) {
+    if (mock_tick()) {
+      mock.wakeups++;
+      return;
+    }
+  }
+  printf("mock: sleep without wake-up\n");
+  exit(2);
+}
+
+void mock_run(uint32_t ticks)
+{
+  while (ticks-- > 0) {
+    mock_tick();
+  }
+}
+
+void mock_flush(void)
+{
+  uint32_t i;
+
+  for (i = 0; i < MOCK_TIMEOUT; i++) {
+    mock_tick();
+    if ( (udr_tx == MOCK_UDR_EMPTY) && (tx_shift == 0) && 
+         (mock.rx_pos == mock.rx_len) && !flag_rxc && 
+         !(regs[MOCK_UCSR0B] & _BV(UDRIE0)) ) {
+      mock_run(1);    // pending TXC interrupt
+      return;
+    }
+  }
+  printf("mock: flush timeout\n");
+  exit(2);
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Host test support for hwserial. 
+ *
+ * The tests are compiled by the host gcc with the mock AVR headers from 
+ * this directory. USART0 is simulated by mock.c:
+ *   - every access to an USART register is one tick of the simulation,
+ *   - a character written to UDR0 is moved to the shift register and it
+ *     is transmitted (appended to mock.tx) after mock.char_ticks ticks,
+ *   - characters given by mock_rx_push are received one per char_ticks,
+ *     a character which is not read before the next one sets DOR,
+ *   - enabled interrupt routines are called at the register accesses 
+ *     of the main program when the I bit of SREG is set (RX before UDRE 
+ *     before TXC, one routine per tick),
+ *   - sleep_cpu runs the simulation until some interrupt routine is called,
+ *   - time0 of avrtime.h is incremented every mock.time0_ticks ticks.
+ */
+
+#ifndef MOCK_H_INCLUDED
+#define MOCK_H_INCLUDED
+
+#include <stdint.h>
+#include <stdio.h>
+#include <avr/io.h>
+
+/* Not a result of conversion of char or uint8_t written to UDR0 */
+#define MOCK_UDR_EMPTY 0x8000
+#define MOCK_BUFFER    4096
+
+typedef struct {
+  uint16_t char_ticks;          // ticks per character (default 10)
+  uint32_t ticks;
+  /* Transmitted characters */
+  uint8_t tx[MOCK_BUFFER];
+  uint16_t tx_len;
+  uint16_t udr_overwrites;      // UDR0 written when UDRE0 was cleared
+  /* Characters for the receiver */
+  uint8_t rx[MOCK_BUFFER];
+  uint16_t rx_len;
+  uint16_t rx_pos;
+  uint16_t rx_overruns;         // DOR - the character was lost
+  /* Calls of the interrupt routines */
+  uint32_t rx_isr;
+  uint32_t udre_isr;
+  uint32_t udre_idle;           // UDRE routine returned without UDR0 write
+  uint32_t txc_isr;
+  uint32_t sleeps;
+  uint32_t wakeups;
+  void (*udre_hook)(void);      // called after every UDRE routine
+  uint16_t time0_ticks;         // ticks per time0 increment, 0 - time0 stops
+} TMock;
+
+extern TMock mock;
+
+/* Reset simulation and registers, interrupts are enabled */
+extern void mock_reset(void);
+
+/* Characters which will be received by USART0 */
+extern void mock_rx_push(const void *data, uint16_t len);
+
+/* Run simulation for ticks (the main program does not access registers) */
+extern void mock_run(uint32_t ticks);
+
+/* Run simulation until all characters are transmitted and received */
+extern void mock_flush(void);
+
+extern int mock_failures;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+      if (!(cond)) {                                                    \
+        printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        mock_failures++;                                                \
+      }                                                                 \
+    } while (0)
+
+/* Return value of main */
+#define MOCK_RESULT(name)                                               \
+    (printf("%s: %s\n", (name), mock_failures ? "FAILED" : "OK"),       \
+     mock_failures ? 1 : 0)
+
+#endif // MOCK_H_INCLUDED
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Autobaud - baud rate computed from synthetic timestamps of the falling
+ * edges of the sync character 0x55 (Timer1 with prescaler 8, F_CPU 16 MHz).
+ */
+#include "../hwserial.c"
+#include "mock.h"
+
+/* Edges of 0x55 sent with baud rate, error in 1/1000 of the rate. One 
+ * interval can be changed by delta ticks. The timer starts at start. */
+static uint32_t measure(uint32_t baud, int16_t error, uint16_t start,
+                        uint8_t interval, int16_t delta)
+{
+  double bit = (F_CPU / 8.0) / (baud * (1000.0 + error) / 1000.0);
+  uint16_t edges[5];
+  uint8_t i;
+
+  for (i = 0; i < 5; i++) {
+    edges[i] = start + (uint16_t) (2 * i * bit + 0.5);
+    if ( (i > 0) && (i - 1 >= interval) ) {
+      edges[i] += delta;
+    }
+  }
+  return hwusart_autobaud_rate(edges);
+}
+
+int main(void)
+{
+  static const uint32_t rates[] = { 
+    1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200, 250000 
+  };
+  uint16_t edges[5] = { 100, 100, 100, 100, 100 };
+  uint8_t i;
+
+  for (i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+    CHECK(measure(rates[i], 0, 1000, 0, 0) == rates[i]);
+    CHECK(measure(rates[i], 0, 65000, 0, 0) == rates[i]);   // TCNT1 wraps
+    CHECK(measure(rates[i], 20, 0, 0, 0) == rates[i]);      // +2 %
+    CHECK(measure(rates[i], -20, 0, 0, 0) == rates[i]);
+  }
+  /* Not a standard rate - measured value is returned */
+  CHECK(measure(10000, 0, 0, 0, 0) == 10000);
+  CHECK(measure(100000, 0, 0, 0, 0) == 100000);
+  /* One interval of one or three bit times (other character than 0x55) */
+  CHECK(measure(9600, 0, 0, 1, -208) == 0);
+  CHECK(measure(9600, 0, 0, 2, 208) == 0);
+  /* Small jitter of one edge is accepted */
+  CHECK(measure(9600, 0, 0, 1, 10) == 9600);
+  CHECK(hwusart_autobaud_rate(edges) == 0);
+
+  return MOCK_RESULT("test-autobaud");
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Pin handles of avrio.h - pin_resolve finds the PIN register of every 
+ * pin, pin_mode/write/toggle change only the DDR or PORT byte of the pin 
+ * and pin_read reads the PIN byte. Compiled for ATmega328P (test-avrio)
+ * and ATmega2560 (test-avrio2560, IO_REG16 - 16-bit register table, 
+ * PINH at 0x100, the handle must still access single bytes).
+ */
+#define MOCK_GPIO
+#include "../../BASE/avrio.c"
+#include "mock.h"
+
+#ifdef MOCK_ATMEGA2560
+  static const uint16_t pin_regs[] = {
+    0x20, 0x23, 0x26, 0x29, 0x2C, 0x2F, 0x32, 0x100, 0, 0x103, 0x106, 0x109
+  };
+  #ifndef IO_REG16
+    #error IO_REG16 is expected for ATmega2560
+  #endif
+#else
+  static const uint16_t pin_regs[] = { 0, 0x23, 0x26, 0x29 };
+  #ifdef IO_REG16
+    #error IO_REG16 is not expected for ATmega328P
+  #endif
+#endif
+#define PORTS (sizeof(pin_regs) / sizeof(pin_regs[0]))
+
+/* Handle with the register address moved into mock_gpio */
+static TPinHandle mock_handle(TPinHandle handle)
+{
+  handle.reg = (void *) (mock_gpio + (uintptr_t) handle.reg);
+  return handle;
+}
+
+/* Only the byte at address is not zero and it equals value */
+static uint8_t gpio_only(uint16_t address, uint8_t value)
+{
+  uint16_t i;
+
+  for (i = 0; i < MOCK_GPIO_SIZE; i++) {
+    if (mock_gpio[i] != ((i == address) ? value : 0)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int main(void)
+{
+  TPinHandle handle, h;
+  uint16_t reg;
+  uint8_t port, bit, mask;
+
+  for (port = 0; port < PORTS; port++) {
+    if (pin_regs[port] == 0) {
+      continue;     // No such port
+    }
+    for (bit = 0; bit < 8; bit++) {
+      reg = pin_regs[port];
+      mask = _BV(bit);
+      handle = pin_resolve(port * 8 + bit);
+      CHECK((uintptr_t) handle.reg == reg);
+      CHECK(handle.mask == mask);
+      h = mock_handle(handle);
+
+      memset((void *) mock_gpio, 0, MOCK_GPIO_SIZE);
+      pin_mode(&h, OUTPUT);
+      CHECK(gpio_only(reg + 1, mask));          // DDR
+      pin_write(&h, HIGH);
+      CHECK(mock_gpio[reg + 2] == mask);        // PORT
+      pin_write(&h, LOW);
+      CHECK(gpio_only(reg + 1, mask));
+      pin_toggle(&h);
+      CHECK(mock_gpio[reg + 2] == mask);
+      pin_toggle(&h);
+      CHECK(gpio_only(reg + 1, mask));
+      pin_mode(&h, INPUT_PULLUP);
+      CHECK(gpio_only(reg + 2, mask));
+      pin_mode(&h, INPUT);
+      CHECK(gpio_only(0, 0));
+
+      /* Interrupt safe variants give the same result */
+      atomic_pin_mode(&h, OUTPUT);
+      CHECK(gpio_only(reg + 1, mask));
+      atomic_pin_write(&h, HIGH);
+      CHECK(mock_gpio[reg + 2] == mask);
+      atomic_pin_toggle(&h);
+      CHECK(gpio_only(reg + 1, mask));
+      atomic_pin_mode(&h, INPUT);
+      CHECK(gpio_only(0, 0));
+
+      /* Other bits of the registers are kept */
+      mock_gpio[reg + 1] = ~mask;
+      mock_gpio[reg + 2] = ~mask;
+      pin_write(&h, HIGH);
+      CHECK(mock_gpio[reg + 2] == 0xFF);
+      pin_write(&h, LOW);
+      CHECK(mock_gpio[reg + 2] == (uint8_t) ~mask);
+      pin_mode(&h, OUTPUT);
+      CHECK(mock_gpio[reg + 1] == 0xFF);
+      CHECK(mock_gpio[reg + 3] == 0);
+
+      memset((void *) mock_gpio, 0, MOCK_GPIO_SIZE);
+      CHECK(pin_read(&h) == LOW);
+      mock_gpio[reg] = mask;
+      CHECK(pin_read(&h) == HIGH);
+      mock_gpio[reg] = ~mask;
+      CHECK(pin_read(&h) == LOW);
+    }
+  }
+
+  #ifdef MOCK_ATMEGA2560
+    return MOCK_RESULT("test-avrio2560");
+  #else
+    return MOCK_RESULT("test-avrio");
+  #endif
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Binary log - frames in the TX buffer, nested messages (interrupt 
+ * routine logs while the main program copies its message or text sent 
+ * by send_P) and dropping of messages when the buffer is full. Number of
+ * cli and USART register accesses of one log call is printed.
+ */
+#define USART_TX_BUFFER 32
+#include <avr/pgmspace.h>
+
+/* Interrupt routine called while send_P reads the program memory */
+static void copy_isr(void);
+#undef pgm_read_byte
+#define pgm_read_byte(addr) (copy_isr(), *(const uint8_t *) (addr))
+
+#include "../hwserial.c"
+#include "../binlog.c"
+#include "mock.h"
+
+static const char fmt_a[] = "A %u";
+static const char fmt_b[] = "B %hhu";
+static const char text_P[] PROGMEM = "0123456789";
+static uint8_t copy_isr_countdown;
+static uint8_t b = 0x56;
+
+static void copy_isr(void)
+{
+  uint8_t sreg = SREG;
+
+  if ( (copy_isr_countdown > 0) && (--copy_isr_countdown == 0) ) {
+    cli();
+    binlog_write(fmt_b, &b, sizeof(b));
+    SREG = sreg;
+  }
+}
+
+/* Check the frame at mock.tx[pos], return position of the next one */
+static uint16_t check_frame(uint16_t pos, const char *fmt, 
+                            const void *args, uint8_t len)
+{
+  uint16_t id = (uint16_t) (uintptr_t) fmt;
+
+  CHECK(mock.tx[pos] == (id & 0xFF));
+  CHECK(mock.tx[pos + 1] == (id >> 8));
+  CHECK(mock.tx[pos + 2] == len);
+  CHECK(memcmp(&mock.tx[pos + 3], args, len) == 0);
+  return pos + 3 + len;
+}
+
+int main(void)
+{
+  uint16_t a = 0x1234;
+  uint8_t pos, i;
+  uint16_t tx_pos;
+  uint32_t cli_count = 0, ticks = 0;
+  char header[3] = { (uint16_t) (uintptr_t) fmt_a & 0xFF, 
+                     (uint16_t) (uintptr_t) fmt_a >> 8, 2 };
+
+  mock_reset();
+  usart_init(115200, 8, UARTS_PARITY_NONE, UARTS_STOPBIT_ONE);
+
+  binlog_write(fmt_a, &a, sizeof(a));
+  BINLOG("C");
+  mock_flush();
+  CHECK(mock.tx_len == 8);
+  check_frame(0, fmt_a, &a, sizeof(a));
+  CHECK(mock.tx[7] == 0);
+
+  /* The interrupt routine logs between the reservation and the commit
+   * of the main program, its message is sent after the main one. */
+  mock_reset();
+  CHECK(usart_tx_reserve(sizeof(header) + sizeof(a), &pos));
+  pos = usart_tx_fill(pos, header, sizeof(header));
+  binlog_write(fmt_b, &b, sizeof(b));
+  mock_run(100);
+  CHECK(mock.tx_len == 0);
+  usart_tx_fill(pos, &a, sizeof(a));
+  usart_tx_commit();
+  mock_flush();
+  CHECK(mock.tx_len == 9);
+  tx_pos = check_frame(0, fmt_a, &a, sizeof(a));
+  check_frame(tx_pos, fmt_b, &b, sizeof(b));
+  CHECK(usart_tx_free() == 31);
+
+  /* The interrupt routine logs in the middle of send_P */
+  mock_reset();
+  usart_init(115200, 8, UARTS_PARITY_NONE, UARTS_STOPBIT_ONE);
+  copy_isr_countdown = 5;
+  usart_send_P(text_P, 10);
+  mock_flush();
+  CHECK(mock.tx_len == 14);
+  CHECK(memcmp(mock.tx, "0123456789", 10) == 0);
+  check_frame(10, fmt_b, &b, sizeof(b));
+
+  /* Full buffer - 6 messages of 5 bytes fit into 31 bytes */
+  mock_reset();
+  cli();
+  for (i = 0; i < 7; i++) {
+    binlog_write(fmt_a, &a, sizeof(a));
+  }
+  sei();
+  mock_flush();
+  CHECK(mock.tx_len == 30);
+  CHECK(binlog_dropped() == 1);
+  CHECK(binlog_dropped() == 0);
+  for (tx_pos = 0; tx_pos < 30; ) {
+    tx_pos = check_frame(tx_pos, fmt_a, &a, sizeof(a));
+  }
+
+  /* Cost of one call (the buffer is emptied after every call) */
+  mock_reset();
+  usart_init(115200, 8, UARTS_PARITY_NONE, UARTS_STOPBIT_ONE);
+  for (i = 0; i < 100; i++) {
+    cli();
+    cli_count -= mock_cli_count;
+    ticks -= mock.ticks;
+    binlog_write(fmt_a, &a, sizeof(a));
+    cli_count += mock_cli_count;
+    ticks += mock.ticks;
+    _global_hwusart0.tx_read_pos = _global_hwusart0.tx_write_pos;
+    sei();
+  }
+  printf("binlog_write: %.1f cli, %.1f USART register accesses per call\n",
+         cli_count / 100.0, ticks / 100.0);
+
+  return MOCK_RESULT("test-binlog");
+}
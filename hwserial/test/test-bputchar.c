@@ -0,0 +1,44 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* USART_IDLE_SLEEP without TX buffer - blocking bputchar (used by bprint 
+ * and the number formatting) sleeps until UDRE interrupt instead of busy 
+ * waiting, every sleep is woken up.
+ */
+#define USART_IDLE_SLEEP
+#include "../hwserial.c"
+#include <avr/sleep.h>
+#include "mock.h"
+
+int main(void)
+{
+  mock_reset();
+  usart_init(115200, 8, UARTS_PARITY_NONE, UARTS_STOPBIT_ONE);
+  set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+
+  usart_bprint("HELLO ");
+  usart_print_u16(12345);
+  CHECK(mock.sleeps >= 9);      // the first characters fill UDR and shift register
+  CHECK(mock.wakeups == mock.sleeps);
+  CHECK((SMCR & _SLEEP_MODE_MASK) == SLEEP_MODE_PWR_DOWN);
+  CHECK((UCSR0B & _BV(UDRIE0)) == 0);
+  mock_flush();
+  CHECK(mock.tx_len == 11);
+  CHECK(memcmp(mock.tx, "HELLO 12345", 11) == 0);
+  CHECK(mock.udr_overwrites == 0);
+
+  return MOCK_RESULT("test-bputchar");
+}
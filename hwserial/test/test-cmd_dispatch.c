@@ -0,0 +1,165 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Command dispatcher - recognition of commands and number of program 
+ * memory reads (edge comparisons) per character for 8, 32 and 128 commands
+ * compared with the linear chain of usart_readstr_P calls.
+ */
+#define USART_RX_BUFFER 32
+#include <stdio.h>
+#include <time.h>
+#include <avr/pgmspace.h>
+#include "mock.h"
+
+/* Count the edge characters read by cmd_feed */
+static uint32_t edge_reads;
+#undef pgm_read_byte
+#define pgm_read_byte(addr) (edge_reads++, *(const uint8_t *) (addr))
+/* Handler pointers are 16-bit only on AVR */
+#undef pgm_read_word
+#define pgm_read_word(addr)                                                   \
+  (sizeof(*(addr)) == 2 ? *(const uint16_t *) (addr) : (uintptr_t) pgm_read_ptr(addr))
+
+#include "../hwserial.c"
+#include "../cmd_dispatch.c"
+#include "commands-8.h"
+#include "commands-32.h"
+#include "commands-128.h"
+
+static const char *commands[] = {
+  #define COMMAND(verb, object) #verb "_" #object "\n",
+  #define OBJECT(object)                                                      \
+    COMMAND(GET, object) COMMAND(SET, object) COMMAND(READ, object)           \
+    COMMAND(WRITE, object) COMMAND(START, object) COMMAND(STOP, object)       \
+    COMMAND(SHOW, object) COMMAND(RESET, object)
+  OBJECT(ADC) OBJECT(PWM) OBJECT(LED) OBJECT(TEMP) OBJECT(FAN) OBJECT(MOTOR)
+  OBJECT(RELAY) OBJECT(TIMER) OBJECT(BAUD) OBJECT(MODE) OBJECT(ID) 
+  OBJECT(CLOCK) OBJECT(ALARM) OBJECT(LOG) OBJECT(GAIN) OBJECT(OFFSET)
+};
+
+static uint8_t feed(TCmdDispatcher *cmd, const char *text)
+{
+  uint8_t result = CMD_PENDING;
+
+  while (*text) {
+    result = cmd_feed(cmd, *(text++));
+  }
+  return result;
+}
+
+/* Baseline - the received command is compared with the commands one by 
+   one, i.e. if (usart_readstr_P(PSTR("GET_ADC\n"))) ... else if ... */
+static uint8_t readstr_chain(uint8_t count)
+{
+  uint8_t i;
+
+  for (i = 0; i < count; i++) {
+    if (usart_readstr_P(commands[i])) {
+      return i + 1;
+    }
+  }
+  return CMD_NOMATCH;
+}
+
+/* Feed all count commands repeatedly, print reads and time per character */
+static void benchmark(const TCmdNode *nodes, uint8_t count)
+{
+  TCmdDispatcher cmd;
+  uint32_t chars = 0, max_reads = 0, reads, chain_reads = 0;
+  uint16_t i, repeat;
+  const char *text;
+  clock_t start, chain_ticks = 0;
+  double trie_ns;
+
+  cmd_init(&cmd, nodes, NULL);
+  edge_reads = 0;
+  for (i = 0; i < count; i++) {
+    for (text = commands[i]; *text; text++) {
+      reads = edge_reads;
+      cmd_feed(&cmd, *text);
+      if (edge_reads - reads > max_reads) {
+        max_reads = edge_reads - reads;
+      }
+      chars++;
+    }
+  }
+  reads = edge_reads;
+
+  start = clock();
+  for (repeat = 0; repeat < 10000; repeat++) {
+    for (i = 0; i < count; i++) {
+      CHECK(feed(&cmd, commands[i]) == i + 1);
+    }
+  }
+  trie_ns = 1e9 * (clock() - start) / CLOCKS_PER_SEC / (10000.0 * chars);
+
+  /* The whole command is in the RX buffer, the chain is repeated from 
+     the same read position */
+  for (i = 0; i < count; i++) {
+    mock_rx_push(commands[i], strlen(commands[i]));
+    mock_flush();
+    edge_reads = 0;
+    CHECK(readstr_chain(count) == i + 1);
+    chain_reads += edge_reads;
+    CHECK(usart_available() == 0);
+
+    start = clock();
+    for (repeat = 0; repeat < 1000; repeat++) {
+      _global_hwusart0.rx_read_pos -= strlen(commands[i]);
+      _global_hwusart0.rx_read_pos &= USART_RX_BUFFER - 1;
+      _global_hwusart0.receive_complete = 1;
+      readstr_chain(count);
+    }
+    chain_ticks += clock() - start;
+  }
+
+  printf("%3u commands: trie %.2f reads/char (max %lu), %.1f ns/char, "
+         "readstr_P chain %.1f reads/char, %.1f ns/char on host\n", 
+         count, (double) reads / chars, (unsigned long) max_reads, trie_ns,
+         (double) chain_reads / chars,
+         1e9 * chain_ticks / CLOCKS_PER_SEC / (1000.0 * chars));
+}
+
+int main(void)
+{
+  TCmdDispatcher cmd;
+  uint8_t i;
+
+  cmd_init(&cmd, commands128_nodes, commands128_handlers);
+  for (i = 0; i < 128; i++) {
+    CHECK(feed(&cmd, commands[i]) == i + 1);
+  }
+  CHECK(feed(&cmd, "GET_LED\n") == CMD_GET_LED);
+  CHECK(feed(&cmd, "GGET_LED\n") == CMD_GET_LED);        // retried at root
+  CHECK(feed(&cmd, "GET_GGET_LED\n") == CMD_GET_LED);
+  CHECK(feed(&cmd, "GET_XLED\n") != CMD_GET_LED);
+  CHECK(cmd_feed(&cmd, 'X') == CMD_NOMATCH);
+  CHECK(cmd_feed(&cmd, 'G') == CMD_PENDING);
+  CHECK(cmd_feed(&cmd, 'X') == CMD_NOMATCH);
+  CHECK(cmd.state == 0);
+  CHECK(feed(&cmd, "RESTART_ADC\n") == CMD_START_ADC);  // failure link "RES" -> "S"
+  CHECK(feed(&cmd, "RESHOW_ADC\n") == CMD_SHOW_ADC);
+  CHECK(feed(&cmd, "GET_GESET_LED\n") == CMD_SET_LED);
+
+  mock_reset();
+  usart_init(115200, 8, UARTS_PARITY_NONE, UARTS_STOPBIT_ONE);
+
+  benchmark(commands8_nodes, 8);
+  benchmark(commands32_nodes, 32);
+  benchmark(commands128_nodes, 128);
+
+  return MOCK_RESULT("test-cmd_dispatch");
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* USART_XONXOFF - the initial XON is sent by init, XON received with
+ * nothing to send does not enable UDRIE (RS-485 DE would stay high without
+ * TXC), data paused by XOFF are sent after XON.
+ */
+#define USART_RX_BUFFER 16
+#define USART_TX_BUFFER 16
+#define USART_XONXOFF
+#define USART_IDLE_SLEEP
+#include "../hwserial.c"
+#include "mock.h"
+
+int main(void)
+{
+  const char xon = USART_XON;
+  const char xoff = USART_XOFF;
+  uint32_t udre;
+
+  mock_reset();
+  usart_init(115200, 8, UARTS_PARITY_NONE, UARTS_STOPBIT_ONE);
+  mock_flush();
+  CHECK(mock.tx_len == 1);
+  CHECK(mock.tx[0] == USART_XON);
+
+  /* XON without data */
+  udre = mock.udre_isr;
+  mock_rx_push(&xon, 1);
+  mock_flush();
+  CHECK(mock.udre_isr == udre);
+  CHECK((UCSR0B & _BV(UDRIE0)) == 0);
+  CHECK(mock.tx_len == 1);
+
+  /* Data paused by XOFF */
+  mock_rx_push(&xoff, 1);
+  mock_flush();
+  usart_print("AB");
+  mock_flush();
+  CHECK(mock.tx_len == 1);
+  mock_rx_push(&xon, 1);
+  mock_flush();
+  CHECK(mock.tx_len == 3);
+  CHECK(memcmp(mock.tx + 1, "AB", 2) == 0);
+  CHECK((UCSR0B & _BV(UDRIE0)) == 0);
+  CHECK(mock.udr_overwrites == 0);
+
+  return MOCK_RESULT("test-flow");
+}
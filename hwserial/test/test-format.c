@@ -0,0 +1,173 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Number formatting - output of hwusart_format_dec/int/hex is compared 
+ * with sprintf, the time per number is compared with sprintf and with 
+ * the division loop of ultoa on the host. The host has a hardware divider,
+ * the times say nothing about AVR cycles.
+ */
+#include <stdlib.h>
+#include <time.h>
+#include "../hwserial.c"
+#include "mock.h"
+
+#define REPEAT 100000
+
+static char out[300];
+static uint16_t out_len;
+
+static void put(char ch)
+{
+  out[out_len++] = ch;
+}
+
+static const char *format_dec(uint32_t value, uint8_t digits)
+{
+  out_len = 0;
+  hwusart_format_dec(put, value, digits, 0);
+  out[out_len] = '\0';
+  return out;
+}
+
+static const char *format_int(int32_t value, uint8_t decimals)
+{
+  out_len = 0;
+  hwusart_format_int(put, value, decimals);
+  out[out_len] = '\0';
+  return out;
+}
+
+static const char *format_hex(uint32_t value, uint8_t digits)
+{
+  out_len = 0;
+  hwusart_format_hex(put, value, digits);
+  out[out_len] = '\0';
+  return out;
+}
+
+/* Equivalent of avr-libc ultoa(value, buffer, 10) - one division by 10 
+   per digit, the digits are reversed */
+static char *ultoa10(uint32_t value, char *buffer)
+{
+  char *p = buffer, *q;
+  char ch;
+
+  do {
+    *(p++) = '0' + value % 10;
+    value /= 10;
+  } while (value > 0);
+  *p = '\0';
+  for (q = buffer, p--; q < p; q++, p--) {
+    ch = *q;
+    *q = *p;
+    *p = ch;
+  }
+  return buffer;
+}
+
+/* Fixed point value formatted by sprintf */
+static const char *fixed(int32_t value, uint8_t decimals)
+{
+  static char ref[300];
+  int64_t v = value;
+  int64_t scale = 1;
+  uint8_t i;
+  int len;
+
+  if (decimals == 0) {
+    sprintf(ref, "%ld", (long) value);
+    return ref;
+  }
+  len = sprintf(ref, "%s", (v < 0) ? "-" : "");
+  v = (v < 0) ? -v : v;
+  for (i = 0; i < decimals; i++) {
+    scale *= 10;
+  }
+  /* integer part, decimal point and decimals digits with leading zeros */
+  len += sprintf(ref + len, "%lld.", (long long) (v / scale));
+  for (i = decimals; i > 0; i--) {
+    ref[len + i - 1] = '0' + v % 10;
+    v /= 10;
+  }
+  ref[len + decimals] = '\0';
+  return ref;
+}
+
+int main(void)
+{
+  static const uint32_t values[] = {
+    0, 1, 9, 10, 99, 100, 255, 256, 999, 1000, 9999, 10000, 65535, 65536,
+    99999, 100000, 999999999, 1000000000, 2147483647, 2147483648UL,
+    4294967295UL
+  };
+  char ref[64];
+  uint32_t value;
+  clock_t start, time_format, time_sprintf, time_ultoa;
+  uint8_t d;
+  uint32_t n;
+
+  srand(1);
+  for (n = 0; n < 100000; n++) {
+    value = (n < sizeof(values) / sizeof(values[0])) ? values[n] :
+            ((uint32_t) rand() << 16) ^ (uint32_t) rand();
+    value >>= rand() % 32;
+
+    sprintf(ref, "%lu", (unsigned long) value);
+    CHECK(strcmp(format_dec(value, 10), ref) == 0);
+    CHECK(strcmp(ultoa10(value, out), ref) == 0);
+    sprintf(ref, "%u", (uint8_t) value);
+    CHECK(strcmp(format_dec((uint8_t) value, 3), ref) == 0);
+    sprintf(ref, "%u", (uint16_t) value);
+    CHECK(strcmp(format_dec((uint16_t) value, 5), ref) == 0);
+    sprintf(ref, "%ld", (long) (int32_t) value);
+    CHECK(strcmp(format_int((int32_t) value, 0), ref) == 0);
+    sprintf(ref, "%08lX", (unsigned long) value);
+    CHECK(strcmp(format_hex(value, 8), ref) == 0);
+    sprintf(ref, "%02X", (uint8_t) value);
+    CHECK(strcmp(format_hex(value, 2), ref) == 0);
+    for (d = 1; d <= 12; d++) {
+      CHECK(strcmp(format_int((int32_t) value, d), fixed((int32_t) value, d)) == 0);
+    }
+  }
+  CHECK(strcmp(format_int(2345, 2), "23.45") == 0);
+  CHECK(strcmp(format_int(5, 3), "0.005") == 0);
+  CHECK(strcmp(format_int(-5, 10), "-0.0000000005") == 0);
+  CHECK(strcmp(format_int(1234, 12), "0.000000001234") == 0);
+  CHECK(strcmp(format_int(INT32_MIN, 10), "-0.2147483648") == 0);
+  CHECK(strcmp(format_int(INT32_MIN, 0), "-2147483648") == 0);
+
+  start = clock();
+  for (n = 0; n < REPEAT; n++) {
+    format_dec(n * 42949U, 10);
+  }
+  time_format = clock() - start;
+  start = clock();
+  for (n = 0; n < REPEAT; n++) {
+    sprintf(out, "%lu", (unsigned long) (n * 42949U));
+  }
+  time_sprintf = clock() - start;
+  start = clock();
+  for (n = 0; n < REPEAT; n++) {
+    ultoa10(n * 42949U, out);
+  }
+  time_ultoa = clock() - start;
+  printf("u32: format_dec %.1f ns, sprintf %.1f ns, ultoa %.1f ns per number on host\n",
+         1e9 * time_format / CLOCKS_PER_SEC / REPEAT,
+         1e9 * time_sprintf / CLOCKS_PER_SEC / REPEAT,
+         1e9 * time_ultoa / CLOCKS_PER_SEC / REPEAT);
+
+  return MOCK_RESULT("test-format");
+}
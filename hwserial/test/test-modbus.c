@@ -0,0 +1,181 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Modbus RTU slave - requests are received by the RX hook of the mocked
+ * USART0, the frame end is given by time0. One character (11 bits at
+ * 19200 Bd, 573 us) takes 40 ticks, time0 (CLK_DIV 8, 128 us) is
+ * incremented every 9 ticks, so 3.5 characters are 17 time0 ticks.
+ */
+#define CLK_DIV 8
+#define USART_RX_BUFFER 0
+#define USART_RX_HOOK modbus_rx_hook
+#define USART_IDLE_SLEEP
+#include "../hwserial.c"
+#include "../modbus.c"
+#include "mock.h"
+
+#define CHAR_TICKS  40
+#define GAP_TICKS   (5 * CHAR_TICKS)    // more than 3.5 characters
+
+static uint16_t holding[8];
+static const uint16_t inputs[2] PROGMEM = {0x1234, 0x5678};
+static uint16_t written_start, written_count;
+
+static void written(uint16_t start, uint16_t count)
+{
+  written_start = start;
+  written_count = count;
+}
+
+static const TModbusMap map = {holding, 8, inputs, 2, 1, written};
+
+/* Append CRC to the frame, return the length with CRC */
+static uint8_t crc(uint8_t *frame, uint8_t len)
+{
+  uint16_t crc = 0xFFFF;
+  uint8_t i;
+
+  for (i = 0; i < len; i++) {
+    crc = _crc16_update(crc, frame[i]);
+  }
+  frame[len++] = crc & 0xFF;
+  frame[len++] = crc >> 8;
+  return len;
+}
+
+/* Poll after the silent interval, send the response and return the result
+   of modbus_poll. The response is in mock.tx. */
+static uint8_t poll(void)
+{
+  uint8_t function;
+
+  mock_run(GAP_TICKS);
+  mock.tx_len = 0;
+  function = modbus_poll();
+  mock_flush();
+  modbus_poll();    // Response sent, receive the next request
+  return function;
+}
+
+static uint8_t request(const uint8_t *frame, uint8_t len)
+{
+  mock_rx_push(frame, len);
+  mock_flush();
+  return poll();
+}
+
+/* Response equals expected data followed by CRC */
+static uint8_t response(const uint8_t *expected, uint8_t len)
+{
+  uint8_t frame[MODBUS_BUFFER];
+
+  memcpy(frame, expected, len);
+  len = crc(frame, len);
+  return (mock.tx_len == len) && (memcmp(mock.tx, frame, len) == 0);
+}
+
+int main(void)
+{
+  uint8_t frame[MODBUS_BUFFER];
+  uint8_t len;
+
+  mock_reset();
+  mock.char_ticks = CHAR_TICKS;
+  mock.time0_ticks = 9;
+  usart_init(19200, 8, UARTS_PARITY_EVEN, 1);
+  modbus_init(1, 19200, &map);
+  CHECK(modbus.gap == 17);
+  holding[1] = 0xA1A2;
+  holding[2] = 0xB1B2;
+
+  /* CRC of the example request from the Modbus specification */
+  memcpy(frame, "\x01\x03\x00\x00\x00\x0A", 6);
+  CHECK(crc(frame, 6) == 8);
+  CHECK((frame[6] == 0xC5) && (frame[7] == 0xCD));
+
+  /* 3 - Read Holding Registers */
+  memcpy(frame, "\x01\x03\x00\x01\x00\x02", 6);
+  CHECK(request(frame, crc(frame, 6)) == 3);
+  CHECK(response((const uint8_t *) "\x01\x03\x04\xA1\xA2\xB1\xB2", 7));
+
+  /* 4 - Read Input Registers (program memory) */
+  memcpy(frame, "\x01\x04\x00\x00\x00\x02", 6);
+  CHECK(request(frame, crc(frame, 6)) == 4);
+  CHECK(response((const uint8_t *) "\x01\x04\x04\x12\x34\x56\x78", 7));
+
+  /* 6 - Write Single Register, the response is echo */
+  memcpy(frame, "\x01\x06\x00\x05\xAB\xCD", 6);
+  CHECK(request(frame, crc(frame, 6)) == 6);
+  CHECK(response(frame, 6));
+  CHECK(holding[5] == 0xABCD);
+  CHECK((written_start == 5) && (written_count == 1));
+
+  /* 16 - Write Multiple Registers */
+  memcpy(frame, "\x01\x10\x00\x03\x00\x02\x04\x00\x0A\x01\x02", 11);
+  CHECK(request(frame, crc(frame, 11)) == 16);
+  CHECK(response(frame, 6));
+  CHECK((holding[3] == 0x000A) && (holding[4] == 0x0102));
+  CHECK((written_start == 3) && (written_count == 2));
+
+  /* Exceptions - illegal function and address */
+  memcpy(frame, "\x01\x05\x00\x00\xFF\x00", 6);
+  CHECK(request(frame, crc(frame, 6)) == 5);
+  CHECK(response((const uint8_t *) "\x01\x85\x01", 3));
+  memcpy(frame, "\x01\x03\x00\x07\x00\x02", 6);
+  CHECK(request(frame, crc(frame, 6)) == 3);
+  CHECK(response((const uint8_t *) "\x01\x83\x02", 3));
+
+  /* Bad CRC and other slave address - no response */
+  memcpy(frame, "\x01\x06\x00\x00\x12\x34", 6);
+  len = crc(frame, 6);
+  frame[len - 1] ^= 1;
+  CHECK(request(frame, len) == 0);
+  CHECK(mock.tx_len == 0);
+  memcpy(frame, "\x02\x06\x00\x00\x12\x34", 6);
+  CHECK(request(frame, crc(frame, 6)) == 0);
+  CHECK(mock.tx_len == 0);
+  CHECK(holding[0] == 0);
+
+  /* Gap of one character inside the frame - one frame */
+  memcpy(frame, "\x01\x06\x00\x00\x12\x34", 6);
+  len = crc(frame, 6);
+  mock_rx_push(frame, 3);
+  mock_flush();
+  mock_run(CHAR_TICKS);
+  CHECK(modbus_poll() == 0);      // not finished yet
+  CHECK(request(frame + 3, len - 3) == 6);
+  CHECK(response(frame, 6));
+  CHECK(holding[0] == 0x1234);
+
+  /* Gap of 4 characters - two incomplete frames */
+  memcpy(frame, "\x01\x06\x00\x00\x56\x78", 6);
+  len = crc(frame, 6);
+  mock_rx_push(frame, 3);
+  mock_flush();
+  mock_run(4 * CHAR_TICKS);
+  mock_rx_push(frame + 3, len - 3);
+  mock_flush();
+  CHECK(poll() == 0);
+  CHECK(mock.tx_len == 0);
+  CHECK(holding[0] == 0x1234);
+
+  /* Next valid request is processed */
+  memcpy(frame, "\x01\x03\x00\x00\x00\x01", 6);
+  CHECK(request(frame, crc(frame, 6)) == 3);
+  CHECK(response((const uint8_t *) "\x01\x03\x02\x12\x34", 5));
+
+  return MOCK_RESULT("test-modbus");
+}
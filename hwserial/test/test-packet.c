@@ -0,0 +1,166 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Packet mode - COBS encoding by the UDRE interrupt routine is compared 
+ * with the reference encoder, packets are decoded back by the RX interrupt
+ * routine (loopback and full-duplex traffic).
+ */
+#define USART_PACKET
+#define USART_PACKET_CRC
+#define USART_RX_BUFFER 1024
+#include "../hwserial.c"
+#include "mock.h"
+
+static uint16_t scan_max;
+static uint16_t scan_last;
+
+/* Bytes searched for the block end by one UDRE interrupt */
+static void scan_hook(void)
+{
+  uint16_t scan = _global_hwusart0.tx_scan;
+
+  if (scan - scan_last > scan_max) {
+    scan_max = scan - scan_last;
+  }
+  scan_last = scan;
+}
+
+/* Reference COBS encoder with CRC and delimiter */
+static uint16_t encode(const uint8_t *data, uint8_t len, uint8_t *out)
+{
+  uint8_t packet[260];
+  uint16_t crc = 0xFFFF;
+  uint16_t total = len + 2;
+  uint16_t i, code_pos = 0, out_len = 1;
+  uint8_t code = 1;
+
+  for (i = 0; i < len; i++) {
+    packet[i] = data[i];
+    crc = _crc_ccitt_update(crc, data[i]);
+  }
+  packet[len] = crc & 0xFF;
+  packet[len + 1] = crc >> 8;
+
+  for (i = 0; i < total; i++) {
+    if (packet[i] == 0) {
+      out[code_pos] = code;
+      code_pos = out_len++;
+      code = 1;
+    } else {
+      out[out_len++] = packet[i];
+      if (++code == 0xFF) {
+        out[code_pos] = code;
+        code_pos = out_len++;
+        code = 1;
+      }
+    }
+  }
+  out[code_pos] = code;
+  out[out_len++] = 0;
+  return out_len;
+}
+
+static void test_packet(const uint8_t *data, uint8_t len)
+{
+  uint8_t expected[300];
+  uint8_t received[256];
+  uint16_t expected_len = encode(data, len, expected);
+
+  mock_reset();
+  usart_init(115200, 8, UARTS_PARITY_NONE, UARTS_STOPBIT_ONE);
+  scan_last = 0;
+  mock.udre_hook = scan_hook;
+
+  CHECK(usart_packet_send(data, len));
+  CHECK(!usart_packet_send(data, len));   // the first packet is sent
+  mock_flush();
+  CHECK(usart_tx_empty());
+  CHECK(mock.tx_len == expected_len);
+  CHECK(memcmp(mock.tx, expected, expected_len) == 0);
+  CHECK(mock.udr_overwrites == 0);
+
+  /* Loopback */
+  mock_rx_push(mock.tx, mock.tx_len);
+  mock_flush();
+  CHECK(usart_packet_available() == 1);
+  CHECK(usart_packet_len() == len);
+  CHECK(usart_packet_read(received, sizeof(received)) == len);
+  CHECK(memcmp(received, data, len) == 0);
+  CHECK(usart_packet_available() == 0);
+}
+
+/* Packet is received while other packet is sent */
+static void test_full_duplex(const uint8_t *data, uint8_t len)
+{
+  uint8_t encoded[300];
+  uint8_t received[256];
+  uint16_t encoded_len = encode(data, len, encoded);
+
+  mock_reset();
+  usart_init(115200, 8, UARTS_PARITY_NONE, UARTS_STOPBIT_ONE);
+  mock_rx_push(encoded, encoded_len);
+  mock_rx_push(encoded, encoded_len);
+  CHECK(usart_packet_send(data, len));
+  mock_flush();
+  CHECK(usart_packet_send(data, len));
+  mock_flush();
+  CHECK(mock.rx_overruns == 0);
+  CHECK(mock.tx_len == 2 * encoded_len);
+  CHECK(usart_packet_available() == 2);
+  CHECK(usart_packet_read(received, sizeof(received)) == len);
+  CHECK(memcmp(received, data, len) == 0);
+  CHECK(usart_packet_read(received, sizeof(received)) == len);
+  CHECK(memcmp(received, data, len) == 0);
+}
+
+int main(void)
+{
+  uint8_t data[255] = {0};
+  uint16_t i;
+
+  test_packet(data, 0);
+
+  memcpy(data, "\x11\x00\x00\x22\x33\x00", 6);
+  test_packet(data, 6);
+
+  memset(data, 0, sizeof(data));
+  test_packet(data, 255);
+
+  /* Blocks of 254 non-zero bytes */
+  for (i = 0; i < sizeof(data); i++) {
+    data[i] = i % 255 + 1;
+  }
+  scan_max = 0;
+  test_packet(data, 253);
+  test_packet(data, 254);
+  test_packet(data, 255);
+  CHECK(scan_max <= _USART_PACKET_SCAN);
+  CHECK(mock.udre_idle > 0);    // the block end was searched in parts
+
+  srand(1);
+  for (i = 0; i < 200; i++) {
+    uint8_t len = rand() % 256;
+    uint16_t j;
+
+    for (j = 0; j < len; j++) {
+      data[j] = (rand() % 4 == 0) ? 0 : rand();
+    }
+    test_packet(data, len);
+  }
+  test_full_duplex(data, 200);
+
+  return MOCK_RESULT("test-packet");
+}
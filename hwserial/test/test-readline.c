@@ -0,0 +1,96 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Line mode - counting of delimiters and readline with buffer overruns */
+#define USART_RX_DELIMITER '\n'
+#define USART_RX_BUFFER 256
+#include "../hwserial.c"
+#include "mock.h"
+
+static void receive(const char *text)
+{
+  mock_rx_push(text, strlen(text));
+  mock_flush();
+}
+
+/* Number of delimiters in the receive buffer */
+static uint16_t count_lines(void)
+{
+  uint16_t avail = usart_available();
+  uint8_t pos = _global_hwusart0.rx_read_pos;
+  uint16_t lines = 0;
+
+  while (avail-- > 0) {
+    lines += (_global_hwusart0.rx_buffer[pos++] == '\n');
+  }
+  return lines;
+}
+
+int main(void)
+{
+  char line[16];
+  uint16_t i;
+
+  mock_reset();
+  usart_init(115200, 8, UARTS_PARITY_NONE, UARTS_STOPBIT_ONE);
+
+  receive("LED 1\nSTAT");
+  CHECK(usart_lines_available() == 1);
+  CHECK(usart_readline(line, sizeof(line)) == 5);
+  CHECK(strcmp(line, "LED 1") == 0);
+  CHECK(usart_lines_available() == 0);
+  CHECK(usart_readline(line, sizeof(line)) == 0);
+  CHECK(line[0] == '\0');
+  receive("US\n");
+  CHECK(usart_readline(line, 4) == 3);    // truncated
+  CHECK(strcmp(line, "STA") == 0);
+  CHECK(usart_available() == 0);
+
+  /* Full buffer of delimiters - 256 lines */
+  for (i = 0; i < 256; i++) {
+    receive("\n");
+  }
+  CHECK(usart_available() == 256);
+  CHECK(usart_lines_available() == 256);
+  CHECK(usart_readline(line, sizeof(line)) == 0);
+  CHECK(usart_lines_available() == 255);
+  usart_clear();
+
+  /* Overrun - the oldest lines are overwritten and not counted */
+  for (i = 0; i < 100; i++) {
+    receive("line\n");
+  }
+  CHECK(usart_overrun());
+  CHECK(usart_lines_available() == count_lines());
+  while (usart_lines_available() > 0) {
+    usart_readline(line, sizeof(line));
+  }
+  CHECK(count_lines() == 0);
+  usart_clear();
+
+  /* The delimiter was overwritten during readline (the interrupt routine
+     decrements the counter later) - the scan ends at the end of data */
+  receive("abc\n");
+  _global_hwusart0.rx_buffer[3] = 'x';
+  CHECK(usart_readline(line, sizeof(line)) == 0);
+  CHECK(line[0] == '\0');
+  CHECK(usart_lines_available() == 1);
+  _global_hwusart0.rx_lines = 0;
+  CHECK(usart_readline(line, sizeof(line)) == 0);
+  CHECK(usart_lines_available() == 0);
+
+  return MOCK_RESULT("test-readline");
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Zero-copy receive - rx_peek/rx_consume return the same data as getchar
+ * (also when the data wrap around the end of the buffer). Parsing of 
+ * received data by getchar and by rx_peek is compared: number of blocks
+ * with disabled interrupts and time on the host per byte.
+ */
+#define USART_RX_BUFFER 1024
+#include <time.h>
+#include "../hwserial.c"
+#include "mock.h"
+
+#define FRAME  1000
+#define REPEAT 200
+
+static uint8_t frame[FRAME];
+
+static void receive(void)
+{
+  mock_rx_push(frame, FRAME);
+  mock_flush();
+}
+
+static uint32_t parse_getchar(void)
+{
+  uint32_t sum = 0;
+
+  while (usart_available()) {
+    sum += (uint8_t) usart_getchar();
+  }
+  return sum;
+}
+
+static uint32_t parse_peek(void)
+{
+  const char *data;
+  uint32_t sum = 0;
+  uint16_t len, i;
+
+  while ( (len = usart_rx_peek(&data)) > 0 ) {
+    for (i = 0; i < len; i++) {
+      sum += (uint8_t) data[i];
+    }
+    usart_rx_consume(len);
+  }
+  return sum;
+}
+
+/* Parse REPEAT frames, print cli calls and host time per byte */
+static uint32_t benchmark(const char *name, uint32_t (*parse)(void))
+{
+  uint32_t sum = 0, cli_count = 0;
+  clock_t time = 0, start;
+  uint16_t i;
+
+  for (i = 0; i < REPEAT; i++) {
+    receive();
+    cli_count -= mock_cli_count;
+    start = clock();
+    sum += parse();
+    time += clock() - start;
+    cli_count += mock_cli_count;
+  }
+  printf("%-8s %.3f cli/byte, %.1f ns/byte on host\n", name,
+         (double) cli_count / (REPEAT * FRAME),
+         1e9 * time / CLOCKS_PER_SEC / (REPEAT * FRAME));
+  return sum;
+}
+
+int main(void)
+{
+  const char *data;
+  uint32_t sum = 0;
+  uint16_t i;
+
+  for (i = 0; i < FRAME; i++) {
+    frame[i] = i * 7;
+    sum += frame[i];
+  }
+  mock_reset();
+  usart_init(115200, 8, UARTS_PARITY_NONE, UARTS_STOPBIT_ONE);
+
+  /* The second frame wraps - two blocks */
+  receive();
+  CHECK(usart_rx_peek(&data) == FRAME);
+  CHECK(memcmp(data, frame, FRAME) == 0);
+  usart_rx_consume(FRAME);
+  receive();
+  CHECK(usart_rx_peek(&data) == 1024 - FRAME);
+  CHECK(memcmp(data, frame, 1024 - FRAME) == 0);
+  usart_rx_consume(1024 - FRAME);
+  CHECK(usart_rx_peek(&data) == 2 * FRAME - 1024);
+  CHECK(memcmp(data, frame + 1024 - FRAME, 2 * FRAME - 1024) == 0);
+  usart_rx_consume(5000);     // at most available
+  CHECK(usart_available() == 0);
+  CHECK(usart_rx_peek(&data) == 0);
+
+  CHECK(benchmark("getchar", parse_getchar) == REPEAT * sum);
+  CHECK(benchmark("rx_peek", parse_peek) == REPEAT * sum);
+
+  return MOCK_RESULT("test-rxpeek");
+}
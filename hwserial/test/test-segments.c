@@ -0,0 +1,49 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* send_segments without TX buffer - text segments are marked by
+ * USART_SEGMENT_TEXT, a binary segment of length 0 sends nothing.
+ */
+#define USART_IDLE_SLEEP
+#include "../hwserial.c"
+#include "mock.h"
+
+static const char header_P[] PROGMEM = "T=";
+
+int main(void)
+{
+  const char raw[3] = {'\0', 'x', '\0'};
+  const TUsartSegment msg[] = {
+    {header_P, 0, USART_SEGMENT_PGM | USART_SEGMENT_TEXT},
+    {raw, 0, USART_SEGMENT_RAM},
+    {"25", 0, USART_SEGMENT_RAM | USART_SEGMENT_TEXT},
+    {raw, sizeof(raw), USART_SEGMENT_RAM},
+    {"", 0, USART_SEGMENT_RAM | USART_SEGMENT_TEXT},
+    {header_P, 1, USART_SEGMENT_PGM},
+  };
+
+  mock_reset();
+  usart_init(115200, 8, UARTS_PARITY_NONE, UARTS_STOPBIT_ONE);
+  usart_send_segments(msg, sizeof(msg) / sizeof(msg[0]));
+  usart_tx_wait();
+  mock_flush();
+  CHECK(mock.tx_len == 8);
+  CHECK(memcmp(mock.tx, "T=25\0x\0T", 8) == 0);
+  CHECK(mock.udr_overwrites == 0);
+  CHECK(usart_tx_empty());
+
+  return MOCK_RESULT("test-segments");
+}
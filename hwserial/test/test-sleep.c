@@ -0,0 +1,67 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* USART_IDLE_SLEEP - waiting functions sleep in the IDLE mode, every 
+ * sleep is woken up, the data are complete and the sleep mode of the 
+ * application is restored.
+ */
+#define USART_TX_BUFFER 16
+#define USART_IDLE_SLEEP
+#include "../hwserial.c"
+#include <avr/sleep.h>
+#include "mock.h"
+
+int main(void)
+{
+  char data[200];
+  uint16_t i;
+
+  for (i = 0; i < sizeof(data); i++) {
+    data[i] = 'A' + i % 26;
+  }
+  mock_reset();
+  usart_init(115200, 8, UARTS_PARITY_NONE, UARTS_STOPBIT_ONE);
+  set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+
+  /* The buffer is full after 15 bytes, send waits for free space */
+  usart_send(data, sizeof(data));
+  CHECK(mock.sleeps > 0);
+  CHECK(mock.wakeups == mock.sleeps);
+  CHECK((SMCR & _SLEEP_MODE_MASK) == SLEEP_MODE_PWR_DOWN);
+  CHECK((SMCR & _BV(SE)) == 0);
+
+  usart_tx_wait();
+  CHECK(usart_tx_empty());
+  CHECK(mock.wakeups == mock.sleeps);
+  CHECK((SMCR & _SLEEP_MODE_MASK) == SLEEP_MODE_PWR_DOWN);
+  mock_flush();
+  CHECK(mock.tx_len == sizeof(data));
+  CHECK(memcmp(mock.tx, data, sizeof(data)) == 0);
+  CHECK(mock.udr_overwrites == 0);
+
+  /* Blocking putchar - the sleep mode is kept when it does not sleep */
+  mock_reset();
+  usart_init(115200, 8, UARTS_PARITY_NONE, UARTS_STOPBIT_ONE);
+  set_sleep_mode(SLEEP_MODE_PWR_SAVE);
+  usart_bputchar('X');
+  CHECK(mock.wakeups == mock.sleeps);
+  CHECK((SMCR & _SLEEP_MODE_MASK) == SLEEP_MODE_PWR_SAVE);
+  mock_flush();
+  CHECK(mock.tx_len == 1);
+  CHECK(mock.tx[0] == 'X');
+
+  return MOCK_RESULT("test-sleep");
+}
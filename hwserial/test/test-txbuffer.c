@@ -0,0 +1,96 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* TX buffer - data queued by send/print/putchar are copied at once, 
+ * the UDRE interrupt routine sends one byte per call and nothing is lost
+ * when the buffer wraps or it is full (the sender sleeps, USART_IDLE_SLEEP).
+ */
+#define USART_TX_BUFFER 16
+#define USART_IDLE_SLEEP
+#include "../hwserial.c"
+#include "mock.h"
+
+static const char text_P[] PROGMEM = "pgm";
+
+int main(void)
+{
+  char data[8] = "abcdefg";
+  char expected[MOCK_BUFFER];
+  uint16_t len = 0;
+  uint16_t i, n;
+
+  mock_reset();
+  usart_init(115200, 8, UARTS_PARITY_NONE, UARTS_STOPBIT_ONE);
+  CHECK(usart_tx_free() == 15);
+
+  /* Everything fits into the buffer - no waiting, the caller can reuse
+     its data at once */
+  cli();
+  usart_send(data, 7);
+  data[0] = 'X';
+  usart_print_P(text_P);
+  usart_print("!");
+  usart_putchar('\n');
+  CHECK(usart_tx_free() == 3);
+  CHECK(mock.tx_len == 0);
+  sei();
+  mock_flush();
+  CHECK(mock.tx_len == 12);
+  CHECK(memcmp(mock.tx, "abcdefgpgm!\n", 12) == 0);
+  CHECK(mock.udre_isr == 12);     // one byte per interrupt
+  CHECK(mock.udre_idle == 0);
+  CHECK(usart_tx_free() == 15);
+  CHECK(usart_tx_empty());
+
+  /* Segments are copied one by one, length 0 without USART_SEGMENT_TEXT
+     sends nothing */
+  {
+    const TUsartSegment msg[] = {
+      {text_P, 0, USART_SEGMENT_PGM | USART_SEGMENT_TEXT},
+      {data, 0, USART_SEGMENT_RAM},
+      {data, 2, USART_SEGMENT_RAM},
+      {"!", 0, USART_SEGMENT_RAM | USART_SEGMENT_TEXT},
+    };
+    mock_reset();
+    usart_init(115200, 8, UARTS_PARITY_NONE, UARTS_STOPBIT_ONE);
+    usart_send_segments(msg, 4);
+    mock_flush();
+    CHECK(mock.tx_len == 6);
+    CHECK(memcmp(mock.tx, "pgmXb!", 6) == 0);
+  }
+
+  /* Blocks of 1..40 bytes - the buffer wraps and it is full many times */
+  mock_reset();
+  usart_init(115200, 8, UARTS_PARITY_NONE, UARTS_STOPBIT_ONE);
+  for (n = 1; n <= 40; n++) {
+    for (i = 0; i < n; i++) {
+      expected[len + i] = (char) (len + i);
+    }
+    usart_send(&expected[len], n);
+    len += n;
+  }
+  usart_tx_wait();
+  mock_flush();
+  CHECK(mock.tx_len == len);
+  CHECK(memcmp(mock.tx, expected, len) == 0);
+  CHECK(mock.udre_isr == len);
+  CHECK(mock.udre_idle == 0);
+  CHECK(mock.udr_overwrites == 0);
+  CHECK(mock.sleeps > 0);
+  CHECK(mock.wakeups == mock.sleeps);
+
+  return MOCK_RESULT("test-txbuffer");
+}
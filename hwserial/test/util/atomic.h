@@ -0,0 +1,51 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MOCK_UTIL_ATOMIC_H_INCLUDED
+#define MOCK_UTIL_ATOMIC_H_INCLUDED
+
+#include <avr/interrupt.h>
+
+/* Same construction as avr-libc - SREG is restored also when the block
+ * is left by return. Interrupts of the simulated USART are not called 
+ * while the I bit of SREG is cleared (see mock.c).
+ */
+static inline uint8_t __iCliRetVal(void)
+{
+  cli();
+  return 1;
+}
+
+static inline void __iRestore(const uint8_t *sreg)
+{
+  SREG = *sreg;
+}
+
+static inline void __iSeiParam(const uint8_t *unused)
+{
+  (void) unused;
+  sei();
+}
+
+#define ATOMIC_BLOCK(type) \
+    for (type, __ToDo = __iCliRetVal(); __ToDo; __ToDo = 0)
+
+#define ATOMIC_RESTORESTATE \
+    uint8_t sreg_save __attribute__((__cleanup__(__iRestore))) = SREG
+#define ATOMIC_FORCEON \
+    uint8_t sreg_save __attribute__((__cleanup__(__iSeiParam))) = 0
+
+#endif // MOCK_UTIL_ATOMIC_H_INCLUDED
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2015 Martin Vyskocil <m.vyskoc@seznam.cz>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MOCK_UTIL_CRC16_H_INCLUDED
+#define MOCK_UTIL_CRC16_H_INCLUDED
+
+#include <stdint.h>
+
+/* C equivalents of the avr-libc functions (from avr-libc documentation) */
+static inline uint16_t _crc16_update(uint16_t crc, uint8_t a)
+{
+  uint8_t i;
+
+  crc ^= a;
+  for (i = 0; i < 8; i++) {
+    if (crc & 1) {
+      crc = (crc >> 1) ^ 0xA001;
+    } else {
+      crc = (crc >> 1);
+    }
+  }
+  return crc;
+}
+
+static inline uint16_t _crc_ccitt_update(uint16_t crc, uint8_t data)
+{
+  data ^= crc & 0xFF;
+  data ^= data << 4;
+  return ((((uint16_t) data << 8) | (crc >> 8)) ^ (uint8_t) (data >> 4) ^ 
+          ((uint16_t) data << 3));
+}
+
+#endif // MOCK_UTIL_CRC16_H_INCLUDED